@@ -0,0 +1,1127 @@
+/*
+AES (advanced encryption standard) block cipher and modes of operation
+- AES-128, AES-256
+- CTR mode
+- GCM mode (authenticated encryption)
+
+William Denny
+
+    - Only the forward cipher is implemented, CTR and GCM both use AES to generate a keystream
+
+    - Parameters:
+        block size = 128 bits = 16 bytes
+        AES-128: key = 16 bytes, Nk = 4, Nr = 10
+        AES-256: key = 32 bytes, Nk = 8, Nr = 14
+
+    - Backends:
+        portable    constant-time and bitsliced, 4 blocks are held as 8 64-bit words (word k holds bit k of
+                    every byte) and SubBytes is evaluated as the Boyar-Peralta boolean circuit, so there are
+                    no table lookups or secret-dependent memory accesses, GHASH uses integer multiplications
+                    on operands masked to every fourth bit so that the carries land in the unused bits
+        AES-NI      8 counter blocks are encrypted in parallel to hide the aesenc latency,
+                    GHASH uses PCLMULQDQ with 8 blocks aggregated into a single reduction
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <assert.h>
+#include <cstring>
+#include <stdexcept>
+
+#include "crypto_useful.hpp"
+
+namespace gv
+{
+
+// **************************************************************************************************************
+// AES
+// **************************************************************************************************************
+
+// AES parameters/datatypes
+
+const uint32_t aes_block_bytes = 16;
+
+// number of blocks processed together by the accelerated backend
+const uint32_t aes_parallel_blocks = 8;
+
+// number of blocks processed together by the portable (bitsliced) backend
+const uint32_t aes_sliced_blocks = 4;
+
+using aes_block = std::array<uint8_t, 16>;
+
+// **************************************************************************************************************
+
+class aes
+{
+
+public:
+    // key must be 16 bytes (AES-128) or 32 bytes (AES-256)
+    aes(const std::string& key);
+
+    // encrypts a single 16-byte block
+    void encrypt_block(const uint8_t* in, uint8_t* out) const;
+
+    // CTR mode
+    // counter is a 16-byte initial counter block, the last 4 bytes are a big-endian block counter
+    // that is incremented modulo 2^32 (as in GCM), so at most 2^32 blocks may use one counter block
+    // encryption and decryption are the same operation; in and out may alias
+    void ctr_crypt(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const;
+    std::string ctr(const std::string& counter, const std::string& str) const;
+
+    uint32_t rounds() const { return num_rounds; }
+
+    static uint8_t gf_mul(uint8_t a, uint8_t b);
+    static uint8_t sbox(uint8_t x);
+
+private:
+    // expanded key, (Nr + 1) round keys of 16 bytes
+    alignas(16) std::array<uint8_t, 15*16> round_keys;
+    uint32_t num_rounds;
+
+    // round keys in bitsliced form, 8 words per round key replicated over the aes_sliced_blocks slots
+    std::array<uint64_t, 15*8> round_key_planes;
+
+    void expand_key(const std::string& key);
+
+    // bitsliced state: word k holds bit k of the 64 bytes of 4 blocks, byte i of block b is bit 16*b + i
+    static uint64_t transpose_8x8(uint64_t x);
+    static void slice_blocks(const uint8_t* in, uint64_t* q);
+    static void unslice_blocks(const uint64_t* q, uint8_t* out);
+    static void sub_bytes_sliced(uint64_t* q);
+    static void shift_rows_sliced(uint64_t* q);
+    static void mix_columns_sliced(uint64_t* q);
+
+    // encrypts up to aes_sliced_blocks blocks
+    void encrypt_blocks_portable(const uint8_t* in, uint8_t* out, size_t num_blocks) const;
+    void ctr_crypt_portable(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const;
+
+#ifdef GV_X86_DISPATCH
+    void ctr_crypt_aesni(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const;
+#endif
+
+    friend class aes_gcm;
+};
+
+// multiplication in GF(2^8) modulo x^8 + x^4 + x^3 + x + 1
+// branchless so that the running time does not depend on a or b
+uint8_t aes::gf_mul(uint8_t a, uint8_t b)
+{
+    uint8_t p = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        p ^= a & (uint8_t)(-(b & 1));
+        uint8_t carry = (uint8_t)(-(a >> 7));
+        a = (uint8_t)(a << 1) ^ (carry & 0x1b);
+        b >>= 1;
+    }
+    return p;
+}
+
+// SubBytes on every byte of the bitsliced state, the Boyar-Peralta circuit with 32 AND gates
+// (an inversion in GF(2^8) through the tower field GF(((2^2)^2)^2) followed by the affine transformation)
+void aes::sub_bytes_sliced(uint64_t* q)
+{
+    uint64_t x0 = q[7], x1 = q[6], x2 = q[5], x3 = q[4], x4 = q[3], x5 = q[2], x6 = q[1], x7 = q[0];
+
+    // top linear transformation
+    uint64_t y14 = x3 ^ x5;
+    uint64_t y13 = x0 ^ x6;
+    uint64_t y9 = x0 ^ x3;
+    uint64_t y8 = x0 ^ x5;
+    uint64_t t0 = x1 ^ x2;
+    uint64_t y1 = t0 ^ x7;
+    uint64_t y4 = y1 ^ x3;
+    uint64_t y12 = y13 ^ y14;
+    uint64_t y2 = y1 ^ x0;
+    uint64_t y5 = y1 ^ x6;
+    uint64_t y3 = y5 ^ y8;
+    uint64_t t1 = x4 ^ y12;
+    uint64_t y15 = t1 ^ x5;
+    uint64_t y20 = t1 ^ x1;
+    uint64_t y6 = y15 ^ x7;
+    uint64_t y10 = y15 ^ t0;
+    uint64_t y11 = y20 ^ y9;
+    uint64_t y7 = x7 ^ y11;
+    uint64_t y17 = y10 ^ y11;
+    uint64_t y19 = y10 ^ y8;
+    uint64_t y16 = t0 ^ y11;
+    uint64_t y21 = y13 ^ y16;
+    uint64_t y18 = x0 ^ y16;
+
+    // nonlinear section, the inversion
+    uint64_t t2 = y12 & y15;
+    uint64_t t3 = y3 & y6;
+    uint64_t t4 = t3 ^ t2;
+    uint64_t t5 = y4 & x7;
+    uint64_t t6 = t5 ^ t2;
+    uint64_t t7 = y13 & y16;
+    uint64_t t8 = y5 & y1;
+    uint64_t t9 = t8 ^ t7;
+    uint64_t t10 = y2 & y7;
+    uint64_t t11 = t10 ^ t7;
+    uint64_t t12 = y9 & y11;
+    uint64_t t13 = y14 & y17;
+    uint64_t t14 = t13 ^ t12;
+    uint64_t t15 = y8 & y10;
+    uint64_t t16 = t15 ^ t12;
+    uint64_t t17 = t4 ^ t14;
+    uint64_t t18 = t6 ^ t16;
+    uint64_t t19 = t9 ^ t14;
+    uint64_t t20 = t11 ^ t16;
+    uint64_t t21 = t17 ^ y20;
+    uint64_t t22 = t18 ^ y19;
+    uint64_t t23 = t19 ^ y21;
+    uint64_t t24 = t20 ^ y18;
+
+    uint64_t t25 = t21 ^ t22;
+    uint64_t t26 = t21 & t23;
+    uint64_t t27 = t24 ^ t26;
+    uint64_t t28 = t25 & t27;
+    uint64_t t29 = t28 ^ t22;
+    uint64_t t30 = t23 ^ t24;
+    uint64_t t31 = t22 ^ t26;
+    uint64_t t32 = t31 & t30;
+    uint64_t t33 = t32 ^ t24;
+    uint64_t t34 = t23 ^ t33;
+    uint64_t t35 = t27 ^ t33;
+    uint64_t t36 = t24 & t35;
+    uint64_t t37 = t36 ^ t34;
+    uint64_t t38 = t27 ^ t36;
+    uint64_t t39 = t29 & t38;
+    uint64_t t40 = t25 ^ t39;
+
+    uint64_t t41 = t40 ^ t37;
+    uint64_t t42 = t29 ^ t33;
+    uint64_t t43 = t29 ^ t40;
+    uint64_t t44 = t33 ^ t37;
+    uint64_t t45 = t42 ^ t41;
+    uint64_t z0 = t44 & y15;
+    uint64_t z1 = t37 & y6;
+    uint64_t z2 = t33 & x7;
+    uint64_t z3 = t43 & y16;
+    uint64_t z4 = t40 & y1;
+    uint64_t z5 = t29 & y7;
+    uint64_t z6 = t42 & y11;
+    uint64_t z7 = t45 & y17;
+    uint64_t z8 = t41 & y10;
+    uint64_t z9 = t44 & y12;
+    uint64_t z10 = t37 & y3;
+    uint64_t z11 = t33 & y4;
+    uint64_t z12 = t43 & y13;
+    uint64_t z13 = t40 & y5;
+    uint64_t z14 = t29 & y2;
+    uint64_t z15 = t42 & y9;
+    uint64_t z16 = t45 & y14;
+    uint64_t z17 = t41 & y8;
+
+    // bottom linear transformation, including the affine map
+    uint64_t t46 = z15 ^ z16;
+    uint64_t t47 = z10 ^ z11;
+    uint64_t t48 = z5 ^ z13;
+    uint64_t t49 = z9 ^ z10;
+    uint64_t t50 = z2 ^ z12;
+    uint64_t t51 = z2 ^ z5;
+    uint64_t t52 = z7 ^ z8;
+    uint64_t t53 = z0 ^ z3;
+    uint64_t t54 = z6 ^ z7;
+    uint64_t t55 = z16 ^ z17;
+    uint64_t t56 = z12 ^ t48;
+    uint64_t t57 = t50 ^ t53;
+    uint64_t t58 = z4 ^ t46;
+    uint64_t t59 = z3 ^ t54;
+    uint64_t t60 = t46 ^ t57;
+    uint64_t t61 = z14 ^ t57;
+    uint64_t t62 = t52 ^ t58;
+    uint64_t t63 = t49 ^ t58;
+    uint64_t t64 = z4 ^ t59;
+    uint64_t t65 = t61 ^ t62;
+    uint64_t t66 = z1 ^ t63;
+    uint64_t s0 = t59 ^ t63;
+    uint64_t s6 = t56 ^ ~t62;
+    uint64_t s7 = t48 ^ ~t60;
+    uint64_t t67 = t64 ^ t65;
+    uint64_t s3 = t53 ^ t66;
+    uint64_t s4 = t51 ^ t66;
+    uint64_t s5 = t47 ^ t65;
+    uint64_t s1 = t64 ^ ~s3;
+    uint64_t s2 = t55 ^ ~t67;
+
+    q[7] = s0; q[6] = s1; q[5] = s2; q[4] = s3; q[3] = s4; q[2] = s5; q[1] = s6; q[0] = s7;
+}
+
+// S-box of a single byte, evaluated with the bitsliced circuit
+uint8_t aes::sbox(uint8_t x)
+{
+    uint64_t q[8];
+    for (int k = 0; k < 8; ++k)
+        q[k] = (x >> k) & 1;
+
+    sub_bytes_sliced(q);
+
+    uint8_t y = 0;
+    for (int k = 0; k < 8; ++k)
+        y |= (uint8_t)((q[k] & 1) << k);
+    return y;
+}
+
+// transposes the 8x8 bit matrix whose row m is byte m of x, so that byte k of the result holds bit k of every byte
+uint64_t aes::transpose_8x8(uint64_t x)
+{
+    uint64_t t;
+    t = (x ^ (x >> 7))  & 0x00aa00aa00aa00aa;  x ^= t ^ (t << 7);
+    t = (x ^ (x >> 14)) & 0x0000cccc0000cccc;  x ^= t ^ (t << 14);
+    t = (x ^ (x >> 28)) & 0x00000000f0f0f0f0;  x ^= t ^ (t << 28);
+    return x;
+}
+
+void aes::slice_blocks(const uint8_t* in, uint64_t* q)
+{
+    for (int k = 0; k < 8; ++k)
+        q[k] = 0;
+
+    for (int j = 0; j < 8; ++j)
+    {
+        uint64_t w = transpose_8x8(load_le<uint64_t>(in + 8*j));
+        for (int k = 0; k < 8; ++k)
+            q[k] |= ((w >> (8*k)) & 0xff) << (8*j);
+    }
+}
+
+void aes::unslice_blocks(const uint64_t* q, uint8_t* out)
+{
+    for (int j = 0; j < 8; ++j)
+    {
+        uint64_t w = 0;
+        for (int k = 0; k < 8; ++k)
+            w |= ((q[k] >> (8*j)) & 0xff) << (8*k);
+        store_le<uint64_t>(out + 8*j, transpose_8x8(w));
+    }
+}
+
+// ShiftRows, byte 4*c + r is row r of column c, so row r of a block rotates right by 4*r bits within its 16 bits
+void aes::shift_rows_sliced(uint64_t* q)
+{
+    for (int k = 0; k < 8; ++k)
+    {
+        uint64_t x = q[k];
+        q[k] = (x & 0x1111111111111111)
+             | ((x >> 4)  & 0x0222022202220222) | ((x << 12) & 0x2000200020002000)
+             | ((x >> 8)  & 0x0044004400440044) | ((x << 8)  & 0x4400440044004400)
+             | ((x >> 12) & 0x0008000800080008) | ((x << 4)  & 0x8880888088808880);
+    }
+}
+
+// MixColumns, col[r] = a_r ^ all ^ 2*(a_r ^ a_r+1) where a_r ^ all = a_r+1 ^ a_r+2 ^ a_r+3
+void aes::mix_columns_sliced(uint64_t* q)
+{
+    // row r of every column takes the byte of row r + 1 or r + 2 (mod 4)
+    auto rot1 = [](uint64_t x) { return ((x >> 1) & 0x7777777777777777) | ((x << 3) & 0x8888888888888888); };
+    auto rot2 = [](uint64_t x) { return ((x >> 2) & 0x3333333333333333) | ((x << 2) & 0xcccccccccccccccc); };
+
+    uint64_t d[8], s[8];
+    for (int k = 0; k < 8; ++k)
+    {
+        uint64_t r1 = rot1(q[k]);
+        d[k] = q[k] ^ r1;
+        s[k] = r1 ^ rot2(d[k]);
+    }
+
+    // multiplication of d by 2, the carry out of bit 7 is reduced by 0x1b
+    q[0] = s[0] ^ d[7];
+    q[1] = s[1] ^ d[0] ^ d[7];
+    q[2] = s[2] ^ d[1];
+    q[3] = s[3] ^ d[2] ^ d[7];
+    q[4] = s[4] ^ d[3] ^ d[7];
+    q[5] = s[5] ^ d[4];
+    q[6] = s[6] ^ d[5];
+    q[7] = s[7] ^ d[6];
+}
+
+aes::aes(const std::string& key)
+{
+    if (key.size() != 16 && key.size() != 32)
+        throw std::invalid_argument("aes: key must be 16 or 32 bytes");
+
+    expand_key(key);
+}
+
+// key expansion (FIPS-197 section 5.2)
+void aes::expand_key(const std::string& key)
+{
+    uint32_t Nk = key.size() / 4;
+    num_rounds = Nk + 6;
+
+    uint32_t num_words = 4 * (num_rounds + 1);
+    uint8_t rcon = 0x01;
+
+    std::memcpy(round_keys.data(), key.data(), key.size());
+
+    for (uint32_t i = Nk; i < num_words; ++i)
+    {
+        uint8_t temp[4];
+        std::memcpy(temp, &round_keys[4*(i - 1)], 4);
+
+        if (i % Nk == 0)
+        {
+            // RotWord, SubWord, XOR Rcon
+            uint8_t t0 = temp[0];
+            temp[0] = sbox(temp[1]) ^ rcon;
+            temp[1] = sbox(temp[2]);
+            temp[2] = sbox(temp[3]);
+            temp[3] = sbox(t0);
+            rcon = gf_mul(rcon, 0x02);
+        }
+        else if (Nk > 6 && i % Nk == 4)
+        {
+            for (int j = 0; j < 4; ++j)
+                temp[j] = sbox(temp[j]);
+        }
+
+        for (int j = 0; j < 4; ++j)
+            round_keys[4*i + j] = round_keys[4*(i - Nk) + j] ^ temp[j];
+    }
+
+    // the same round key in every slot of the bitsliced state
+    for (uint32_t round = 0; round <= num_rounds; ++round)
+    {
+        uint8_t keys[16*aes_sliced_blocks];
+        for (uint32_t b = 0; b < aes_sliced_blocks; ++b)
+            std::memcpy(&keys[16*b], &round_keys[16*round], 16);
+        slice_blocks(keys, &round_key_planes[8*round]);
+    }
+}
+
+// cipher (FIPS-197 section 5.1) on the bitsliced state, unused slots are encrypted as zero blocks
+void aes::encrypt_blocks_portable(const uint8_t* in, uint8_t* out, size_t num_blocks) const
+{
+    uint8_t blocks[16*aes_sliced_blocks] = {0};
+    std::memcpy(blocks, in, 16*num_blocks);
+
+    uint64_t q[8];
+    slice_blocks(blocks, q);
+
+    for (int k = 0; k < 8; ++k)
+        q[k] ^= round_key_planes[k];
+
+    for (uint32_t round = 1; round <= num_rounds; ++round)
+    {
+        sub_bytes_sliced(q);
+        shift_rows_sliced(q);
+
+        // MixColumns, skipped in the final round
+        if (round != num_rounds)
+            mix_columns_sliced(q);
+
+        // AddRoundKey
+        for (int k = 0; k < 8; ++k)
+            q[k] ^= round_key_planes[8*round + k];
+    }
+
+    unslice_blocks(q, blocks);
+    std::memcpy(out, blocks, 16*num_blocks);
+}
+
+void aes::encrypt_block(const uint8_t* in, uint8_t* out) const
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().aesni && cpu().sse41)
+    {
+        // a single CTR block over zeros is the block encryption, E(in) ^ 0 = E(in)
+        uint8_t zero[16] = {0};
+        ctr_crypt_aesni(in, zero, out, 16);
+        return;
+    }
+#endif
+    encrypt_blocks_portable(in, out, 1);
+}
+
+// increments the last 4 bytes of a counter block as a big-endian integer modulo 2^32
+void aes_inc32(uint8_t* counter)
+{
+    for (int i = 15; i >= 12; --i)
+        if (++counter[i] != 0)
+            break;
+}
+
+void aes::ctr_crypt_portable(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const
+{
+    const size_t chunk = 16*aes_sliced_blocks;
+
+    uint8_t ctr_block[16];
+    uint8_t ctr_blocks[16*aes_sliced_blocks];
+    uint8_t keystream[16*aes_sliced_blocks];
+    std::memcpy(ctr_block, counter, 16);
+
+    for (size_t offset = 0; offset < len; offset += chunk)
+    {
+        size_t n = (len - offset < chunk) ? len - offset : chunk;
+        size_t num_blocks = (n + 15) / 16;
+        for (size_t b = 0; b < num_blocks; ++b)
+        {
+            std::memcpy(&ctr_blocks[16*b], ctr_block, 16);
+            aes_inc32(ctr_block);
+        }
+
+        encrypt_blocks_portable(ctr_blocks, keystream, num_blocks);
+        for (size_t i = 0; i < n; ++i)
+            out[offset + i] = in[offset + i] ^ keystream[i];
+    }
+}
+
+void aes::ctr_crypt(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().aesni && cpu().sse41)
+    {
+        ctr_crypt_aesni(counter, in, out, len);
+        return;
+    }
+#endif
+    ctr_crypt_portable(counter, in, out, len);
+}
+
+std::string aes::ctr(const std::string& counter, const std::string& str) const
+{
+    if (counter.size() != 16)
+        throw std::invalid_argument("aes: counter block must be 16 bytes");
+
+    std::string out(str.size(), 0);
+    ctr_crypt((const uint8_t*)counter.data(), (const uint8_t*)str.data(), (uint8_t*)&out[0], str.size());
+    return out;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// one AES round on 8 independent blocks, so that each aesenc overlaps with the previous ones
+#define GV_AESENC_X8(op, b, k) \
+    b[0] = op(b[0], k); b[1] = op(b[1], k); b[2] = op(b[2], k); b[3] = op(b[3], k); \
+    b[4] = op(b[4], k); b[5] = op(b[5], k); b[6] = op(b[6], k); b[7] = op(b[7], k);
+
+__attribute__((target("aes,sse4.1")))
+void aes::ctr_crypt_aesni(const uint8_t* counter, const uint8_t* in, uint8_t* out, size_t len) const
+{
+    __m128i rk[15];
+    for (uint32_t i = 0; i <= num_rounds; ++i)
+        rk[i] = _mm_load_si128((const __m128i*)&round_keys[16*i]);
+
+    __m128i base = _mm_loadu_si128((const __m128i*)counter);
+    uint32_t ctr = ((uint32_t)counter[12] << 24) | ((uint32_t)counter[13] << 16) | ((uint32_t)counter[14] << 8) | counter[15];
+
+    size_t offset = 0;
+
+    // main loop, 8 blocks (128 bytes) at a time
+    for (; offset + 16*aes_parallel_blocks <= len; offset += 16*aes_parallel_blocks)
+    {
+        __m128i b[8];
+        for (int j = 0; j < 8; ++j)
+            b[j] = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(ctr + j), 3), rk[0]);
+        ctr += 8;
+
+        for (uint32_t r = 1; r < num_rounds; ++r)
+        {
+            GV_AESENC_X8(_mm_aesenc_si128, b, rk[r]);
+        }
+        GV_AESENC_X8(_mm_aesenclast_si128, b, rk[num_rounds]);
+
+        for (int j = 0; j < 8; ++j)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(in + offset + 16*j));
+            _mm_storeu_si128((__m128i*)(out + offset + 16*j), _mm_xor_si128(p, b[j]));
+        }
+    }
+
+    // remaining blocks one at a time, the final block may be partial
+    for (; offset < len; offset += 16)
+    {
+        __m128i b = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(ctr), 3), rk[0]);
+        ++ctr;
+
+        for (uint32_t r = 1; r < num_rounds; ++r)
+            b = _mm_aesenc_si128(b, rk[r]);
+        b = _mm_aesenclast_si128(b, rk[num_rounds]);
+
+        if (len - offset >= 16)
+        {
+            __m128i p = _mm_loadu_si128((const __m128i*)(in + offset));
+            _mm_storeu_si128((__m128i*)(out + offset), _mm_xor_si128(p, b));
+        }
+        else
+        {
+            uint8_t keystream[16];
+            _mm_storeu_si128((__m128i*)keystream, b);
+            for (size_t i = 0; i < len - offset; ++i)
+                out[offset + i] = in[offset + i] ^ keystream[i];
+        }
+    }
+}
+
+#endif
+
+// **************************************************************************************************************
+// AES-GCM
+// **************************************************************************************************************
+
+// GCM parameters
+
+const uint32_t gcm_tag_bytes = 16;
+
+const uint32_t gcm_iv_bytes = 12;
+
+// **************************************************************************************************************
+
+class aes_gcm
+{
+
+public:
+    // key must be 16 bytes (AES-128) or 32 bytes (AES-256)
+    aes_gcm(const std::string& key);
+
+    // encrypts plaintext and authenticates it together with aad
+    // returns ciphertext || 16-byte tag
+    // the iv should be 12 bytes (other lengths are hashed into the initial counter block) and must never
+    // be reused with the same key
+    std::string encrypt(const std::string& iv, const std::string& plaintext, const std::string& aad = "") const;
+
+    // decrypts ciphertext || tag into plaintext
+    // returns false (and clears plaintext) if the tag does not match
+    bool decrypt(const std::string& iv, const std::string& ciphertext, std::string& plaintext, const std::string& aad = "") const;
+
+    // raw buffer versions, in and out may alias
+    void encrypt(const uint8_t* iv, size_t iv_len, const uint8_t* aad, size_t aad_len,
+        const uint8_t* in, uint8_t* out, size_t len, uint8_t* tag) const;
+    bool decrypt(const uint8_t* iv, size_t iv_len, const uint8_t* aad, size_t aad_len,
+        const uint8_t* in, uint8_t* out, size_t len, const uint8_t* tag) const;
+
+    // multiplication in GF(2^128) with the GCM bit ordering (SP 800-38D section 6.3)
+    static void gf128_mul(const uint8_t* x, const uint8_t* y, uint8_t* z);
+
+private:
+    aes cipher;
+
+    // hash subkey H = E(K, 0^128)
+    alignas(16) uint8_t H[16];
+
+    // H^1 ... H^8 byte-reversed, used by the PCLMULQDQ backend (H_pow[i] = H^(i+1))
+    alignas(16) uint8_t H_pow[aes_parallel_blocks][16];
+
+    // computes the initial counter block J0 from the iv
+    void initial_counter(const uint8_t* iv, size_t iv_len, uint8_t* J0) const;
+
+    // ghash state Y <- (Y ^ X_i) * H over the blocks of data, the final block is zero-padded
+    void ghash(uint8_t* Y, const uint8_t* data, size_t len) const;
+    void ghash_portable(uint8_t* Y, const uint8_t* data, size_t len) const;
+
+    // carryless multiplication of 64-bit words (low 64 bits of the product) and bit reversal, for ghash_portable
+    static uint64_t bmul64(uint64_t x, uint64_t y);
+    static uint64_t rev64(uint64_t x);
+
+    // generates the tag from the ghash state and the lengths of aad and ciphertext
+    void finish_tag(uint8_t* Y, size_t aad_len, size_t len, const uint8_t* J0, uint8_t* tag) const;
+
+#ifdef GV_X86_DISPATCH
+    bool use_clmul() const { return cpu().aesni && cpu().pclmul && cpu().sse41 && cpu().ssse3; }
+
+    void init_clmul();
+    void ghash_clmul(uint8_t* Y, const uint8_t* data, size_t len) const;
+    void crypt_clmul(const uint8_t* J0, uint8_t* Y, const uint8_t* in, uint8_t* out, size_t len, bool encrypting) const;
+#endif
+};
+
+aes_gcm::aes_gcm(const std::string& key) : cipher(key)
+{
+    uint8_t zero[16] = {0};
+    cipher.encrypt_block(zero, H);
+
+#ifdef GV_X86_DISPATCH
+    if (use_clmul())
+        init_clmul();
+#endif
+}
+
+// reference bitwise multiplication (SP 800-38D algorithm 1), branchless
+void aes_gcm::gf128_mul(const uint8_t* x, const uint8_t* y, uint8_t* z)
+{
+    // bit 0 of a block is the most significant bit of byte 0, so load the blocks big-endian
+    uint64_t x_hi = 0, x_lo = 0, v_hi = 0, v_lo = 0;
+    for (int i = 0; i < 8; ++i)
+    {
+        x_hi = (x_hi << 8) | x[i];
+        x_lo = (x_lo << 8) | x[8 + i];
+        v_hi = (v_hi << 8) | y[i];
+        v_lo = (v_lo << 8) | y[8 + i];
+    }
+
+    uint64_t z_hi = 0, z_lo = 0;
+    for (int i = 0; i < 128; ++i)
+    {
+        uint64_t xi = (i < 64) ? (x_hi >> (63 - i)) & 1 : (x_lo >> (127 - i)) & 1;
+        uint64_t mask = (uint64_t)0 - xi;
+        z_hi ^= v_hi & mask;
+        z_lo ^= v_lo & mask;
+
+        // V <- V >> 1, reduced by R = 11100001 || 0^120 if the dropped bit was set
+        uint64_t lsb = (uint64_t)0 - (v_lo & 1);
+        v_lo = (v_lo >> 1) | (v_hi << 63);
+        v_hi = (v_hi >> 1) ^ (lsb & 0xe100000000000000);
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        z[i]     = (uint8_t)(z_hi >> (56 - 8*i));
+        z[8 + i] = (uint8_t)(z_lo >> (56 - 8*i));
+    }
+}
+
+// integer multiplication with holes: each operand is split into four parts that keep every fourth bit, so in the
+// low 64 bits of an integer product at most 15 partial products meet in a bit and the carries stay in the holes
+uint64_t aes_gcm::bmul64(uint64_t x, uint64_t y)
+{
+    const uint64_t m0 = 0x1111111111111111, m1 = m0 << 1, m2 = m0 << 2, m3 = m0 << 3;
+
+    uint64_t x0 = x & m0, x1 = x & m1, x2 = x & m2, x3 = x & m3;
+    uint64_t y0 = y & m0, y1 = y & m1, y2 = y & m2, y3 = y & m3;
+
+    uint64_t z0 = (x0 * y0) ^ (x1 * y3) ^ (x2 * y2) ^ (x3 * y1);
+    uint64_t z1 = (x0 * y1) ^ (x1 * y0) ^ (x2 * y3) ^ (x3 * y2);
+    uint64_t z2 = (x0 * y2) ^ (x1 * y1) ^ (x2 * y0) ^ (x3 * y3);
+    uint64_t z3 = (x0 * y3) ^ (x1 * y2) ^ (x2 * y1) ^ (x3 * y0);
+
+    return (z0 & m0) | (z1 & m1) | (z2 & m2) | (z3 & m3);
+}
+
+uint64_t aes_gcm::rev64(uint64_t x)
+{
+    x = ((x >> 1)  & 0x5555555555555555) | ((x & 0x5555555555555555) << 1);
+    x = ((x >> 2)  & 0x3333333333333333) | ((x & 0x3333333333333333) << 2);
+    x = ((x >> 4)  & 0x0f0f0f0f0f0f0f0f) | ((x & 0x0f0f0f0f0f0f0f0f) << 4);
+    x = ((x >> 8)  & 0x00ff00ff00ff00ff) | ((x & 0x00ff00ff00ff00ff) << 8);
+    x = ((x >> 16) & 0x0000ffff0000ffff) | ((x & 0x0000ffff0000ffff) << 16);
+    return (x >> 32) | (x << 32);
+}
+
+// constant-time GHASH (as in BearSSL's ghash_ctmul64), the 128-bit product is assembled by Karatsuba from three
+// carryless 64-bit products, whose high halves are the low halves of the products of the bit-reversed operands
+void aes_gcm::ghash_portable(uint8_t* Y, const uint8_t* data, size_t len) const
+{
+    uint64_t h1 = load_be<uint64_t>(H), h0 = load_be<uint64_t>(H + 8);
+    uint64_t h2 = h0 ^ h1;
+    uint64_t h0r = rev64(h0), h1r = rev64(h1), h2r = rev64(h2);
+
+    uint64_t y1 = load_be<uint64_t>(Y), y0 = load_be<uint64_t>(Y + 8);
+
+    for (size_t offset = 0; offset < len; offset += 16)
+    {
+        uint8_t block[16] = {0};
+        size_t n = (len - offset < 16) ? len - offset : 16;
+        std::memcpy(block, data + offset, n);
+
+        y1 ^= load_be<uint64_t>(block);
+        y0 ^= load_be<uint64_t>(block + 8);
+
+        uint64_t y0r = rev64(y0), y1r = rev64(y1);
+        uint64_t y2 = y0 ^ y1, y2r = y0r ^ y1r;
+
+        uint64_t z0 = bmul64(y0, h0), z1 = bmul64(y1, h1), z2 = bmul64(y2, h2);
+        uint64_t z0h = bmul64(y0r, h0r), z1h = bmul64(y1r, h1r), z2h = bmul64(y2r, h2r);
+        z2 ^= z0 ^ z1;
+        z2h ^= z0h ^ z1h;
+        z0h = rev64(z0h) >> 1;
+        z1h = rev64(z1h) >> 1;
+        z2h = rev64(z2h) >> 1;
+
+        // the 256-bit product, shifted left by one bit because of the reflected bit order
+        uint64_t v0 = z0, v1 = z0h ^ z2, v2 = z1 ^ z2h, v3 = z1h;
+        v3 = (v3 << 1) | (v2 >> 63);
+        v2 = (v2 << 1) | (v1 >> 63);
+        v1 = (v1 << 1) | (v0 >> 63);
+        v0 = v0 << 1;
+
+        // reduction modulo x^128 + x^7 + x^2 + x + 1
+        v2 ^= v0 ^ (v0 >> 1) ^ (v0 >> 2) ^ (v0 >> 7);
+        v1 ^= (v0 << 63) ^ (v0 << 62) ^ (v0 << 57);
+        v3 ^= v1 ^ (v1 >> 1) ^ (v1 >> 2) ^ (v1 >> 7);
+        v2 ^= (v1 << 63) ^ (v1 << 62) ^ (v1 << 57);
+
+        y0 = v2;
+        y1 = v3;
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        Y[i]     = (uint8_t)(y1 >> (56 - 8*i));
+        Y[8 + i] = (uint8_t)(y0 >> (56 - 8*i));
+    }
+}
+
+void aes_gcm::ghash(uint8_t* Y, const uint8_t* data, size_t len) const
+{
+#ifdef GV_X86_DISPATCH
+    if (use_clmul())
+    {
+        ghash_clmul(Y, data, len);
+        return;
+    }
+#endif
+    ghash_portable(Y, data, len);
+}
+
+void aes_gcm::initial_counter(const uint8_t* iv, size_t iv_len, uint8_t* J0) const
+{
+    if (iv_len == gcm_iv_bytes)
+    {
+        // J0 = IV || 0^31 || 1
+        std::memcpy(J0, iv, gcm_iv_bytes);
+        J0[12] = 0; J0[13] = 0; J0[14] = 0; J0[15] = 1;
+    }
+    else
+    {
+        // J0 = GHASH(IV || 0^s || 0^64 || [len(IV)]_64)
+        std::memset(J0, 0, 16);
+        ghash(J0, iv, iv_len);
+
+        uint8_t len_block[16] = {0};
+        uint64_t iv_bits = (uint64_t)iv_len * 8;
+        for (int i = 0; i < 8; ++i)
+            len_block[15 - i] = (uint8_t)(iv_bits >> (8*i));
+        ghash(J0, len_block, 16);
+    }
+}
+
+void aes_gcm::finish_tag(uint8_t* Y, size_t aad_len, size_t len, const uint8_t* J0, uint8_t* tag) const
+{
+    // [len(A)]_64 || [len(C)]_64 in bits
+    uint8_t len_block[16];
+    uint64_t aad_bits = (uint64_t)aad_len * 8;
+    uint64_t c_bits = (uint64_t)len * 8;
+    for (int i = 0; i < 8; ++i)
+    {
+        len_block[7 - i]  = (uint8_t)(aad_bits >> (8*i));
+        len_block[15 - i] = (uint8_t)(c_bits >> (8*i));
+    }
+    ghash(Y, len_block, 16);
+
+    // T = E(K, J0) ^ S
+    uint8_t ek[16];
+    cipher.encrypt_block(J0, ek);
+    for (int i = 0; i < 16; ++i)
+        tag[i] = ek[i] ^ Y[i];
+}
+
+void aes_gcm::encrypt(const uint8_t* iv, size_t iv_len, const uint8_t* aad, size_t aad_len,
+    const uint8_t* in, uint8_t* out, size_t len, uint8_t* tag) const
+{
+    uint8_t J0[16];
+    initial_counter(iv, iv_len, J0);
+
+    uint8_t Y[16] = {0};
+    ghash(Y, aad, aad_len);
+
+#ifdef GV_X86_DISPATCH
+    if (use_clmul())
+    {
+        crypt_clmul(J0, Y, in, out, len, true);
+        finish_tag(Y, aad_len, len, J0, tag);
+        return;
+    }
+#endif
+
+    uint8_t ctr_block[16];
+    std::memcpy(ctr_block, J0, 16);
+    aes_inc32(ctr_block);
+
+    cipher.ctr_crypt(ctr_block, in, out, len);
+    ghash(Y, out, len);
+
+    finish_tag(Y, aad_len, len, J0, tag);
+}
+
+bool aes_gcm::decrypt(const uint8_t* iv, size_t iv_len, const uint8_t* aad, size_t aad_len,
+    const uint8_t* in, uint8_t* out, size_t len, const uint8_t* tag) const
+{
+    uint8_t J0[16];
+    initial_counter(iv, iv_len, J0);
+
+    uint8_t Y[16] = {0};
+    ghash(Y, aad, aad_len);
+
+    uint8_t expected[16];
+
+#ifdef GV_X86_DISPATCH
+    if (use_clmul())
+    {
+        crypt_clmul(J0, Y, in, out, len, false);
+    }
+    else
+#endif
+    {
+        // the ciphertext must be hashed before in is overwritten
+        ghash(Y, in, len);
+
+        uint8_t ctr_block[16];
+        std::memcpy(ctr_block, J0, 16);
+        aes_inc32(ctr_block);
+        cipher.ctr_crypt(ctr_block, in, out, len);
+    }
+
+    finish_tag(Y, aad_len, len, J0, expected);
+
+    // compare in constant time
+    uint8_t diff = 0;
+    for (int i = 0; i < 16; ++i)
+        diff |= expected[i] ^ tag[i];
+
+    if (diff != 0)
+    {
+        std::memset(out, 0, len);
+        return false;
+    }
+    return true;
+}
+
+std::string aes_gcm::encrypt(const std::string& iv, const std::string& plaintext, const std::string& aad) const
+{
+    std::string out(plaintext.size() + gcm_tag_bytes, 0);
+    encrypt((const uint8_t*)iv.data(), iv.size(), (const uint8_t*)aad.data(), aad.size(),
+        (const uint8_t*)plaintext.data(), (uint8_t*)&out[0], plaintext.size(), (uint8_t*)&out[plaintext.size()]);
+    return out;
+}
+
+bool aes_gcm::decrypt(const std::string& iv, const std::string& ciphertext, std::string& plaintext, const std::string& aad) const
+{
+    plaintext.clear();
+    if (ciphertext.size() < gcm_tag_bytes)
+        return false;
+
+    size_t len = ciphertext.size() - gcm_tag_bytes;
+    std::string out(len, 0);
+    bool ok = decrypt((const uint8_t*)iv.data(), iv.size(), (const uint8_t*)aad.data(), aad.size(),
+        (const uint8_t*)ciphertext.data(), (uint8_t*)&out[0], len, (const uint8_t*)&ciphertext[len]);
+
+    if (ok)
+        plaintext = std::move(out);
+    return ok;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// the PCLMULQDQ backend works on byte-reversed blocks, so that bit 0 of the GCM block is bit 127 of the register
+// products are computed reflected and shifted left by 1 before reduction (Gueron & Kounavis, Intel white paper)
+
+__attribute__((target("ssse3")))
+__m128i gcm_bswap(__m128i x)
+{
+    return _mm_shuffle_epi8(x, _mm_set_epi8(0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15));
+}
+
+// unreduced 256-bit carry-less product a * b, accumulated into lo/hi
+__attribute__((target("pclmul,sse2")))
+void gcm_clmul_acc(__m128i a, __m128i b, __m128i& lo, __m128i& hi)
+{
+    __m128i t0 = _mm_clmulepi64_si128(a, b, 0x00);
+    __m128i t1 = _mm_clmulepi64_si128(a, b, 0x10);
+    __m128i t2 = _mm_clmulepi64_si128(a, b, 0x01);
+    __m128i t3 = _mm_clmulepi64_si128(a, b, 0x11);
+    t1 = _mm_xor_si128(t1, t2);
+    lo = _mm_xor_si128(lo, _mm_xor_si128(t0, _mm_slli_si128(t1, 8)));
+    hi = _mm_xor_si128(hi, _mm_xor_si128(t3, _mm_srli_si128(t1, 8)));
+}
+
+// reduces a 256-bit reflected product modulo x^128 + x^7 + x^2 + x + 1
+__attribute__((target("sse2")))
+__m128i gcm_reduce(__m128i lo, __m128i hi)
+{
+    // shift the 256-bit product left by 1 to account for the reflected representation
+    __m128i t7 = _mm_srli_epi32(lo, 31);
+    __m128i t8 = _mm_srli_epi32(hi, 31);
+    lo = _mm_slli_epi32(lo, 1);
+    hi = _mm_slli_epi32(hi, 1);
+    __m128i t9 = _mm_srli_si128(t7, 12);
+    t8 = _mm_slli_si128(t8, 4);
+    t7 = _mm_slli_si128(t7, 4);
+    lo = _mm_or_si128(lo, t7);
+    hi = _mm_or_si128(hi, t8);
+    hi = _mm_or_si128(hi, t9);
+
+    // first phase of the reduction
+    t7 = _mm_slli_epi32(lo, 31);
+    t8 = _mm_slli_epi32(lo, 30);
+    t9 = _mm_slli_epi32(lo, 25);
+    t7 = _mm_xor_si128(t7, t8);
+    t7 = _mm_xor_si128(t7, t9);
+    t8 = _mm_srli_si128(t7, 4);
+    t7 = _mm_slli_si128(t7, 12);
+    lo = _mm_xor_si128(lo, t7);
+
+    // second phase of the reduction
+    __m128i t2 = _mm_srli_epi32(lo, 1);
+    __m128i t4 = _mm_srli_epi32(lo, 2);
+    __m128i t5 = _mm_srli_epi32(lo, 7);
+    t2 = _mm_xor_si128(t2, t4);
+    t2 = _mm_xor_si128(t2, t5);
+    t2 = _mm_xor_si128(t2, t8);
+    lo = _mm_xor_si128(lo, t2);
+
+    return _mm_xor_si128(hi, lo);
+}
+
+__attribute__((target("pclmul,ssse3")))
+void aes_gcm::init_clmul()
+{
+    __m128i h = gcm_bswap(_mm_loadu_si128((const __m128i*)H));
+    __m128i p = h;
+    _mm_store_si128((__m128i*)H_pow[0], p);
+
+    for (uint32_t i = 1; i < aes_parallel_blocks; ++i)
+    {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        gcm_clmul_acc(p, h, lo, hi);
+        p = gcm_reduce(lo, hi);
+        _mm_store_si128((__m128i*)H_pow[i], p);
+    }
+}
+
+// aggregated reduction: Y <- (Y ^ X_1)*H^8 ^ X_2*H^7 ^ ... ^ X_8*H, reduced once per 8 blocks
+__attribute__((target("pclmul,ssse3")))
+void aes_gcm::ghash_clmul(uint8_t* Y, const uint8_t* data, size_t len) const
+{
+    __m128i y = gcm_bswap(_mm_loadu_si128((const __m128i*)Y));
+    __m128i h1 = _mm_load_si128((const __m128i*)H_pow[0]);
+
+    size_t offset = 0;
+    for (; offset + 16*aes_parallel_blocks <= len; offset += 16*aes_parallel_blocks)
+    {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (uint32_t j = 0; j < aes_parallel_blocks; ++j)
+        {
+            __m128i x = gcm_bswap(_mm_loadu_si128((const __m128i*)(data + offset + 16*j)));
+            if (j == 0)
+                x = _mm_xor_si128(x, y);
+            gcm_clmul_acc(x, _mm_load_si128((const __m128i*)H_pow[aes_parallel_blocks - 1 - j]), lo, hi);
+        }
+        y = gcm_reduce(lo, hi);
+    }
+
+    for (; offset < len; offset += 16)
+    {
+        alignas(16) uint8_t block[16] = {0};
+        size_t n = (len - offset < 16) ? len - offset : 16;
+        std::memcpy(block, data + offset, n);
+
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        gcm_clmul_acc(_mm_xor_si128(y, gcm_bswap(_mm_load_si128((const __m128i*)block))), h1, lo, hi);
+        y = gcm_reduce(lo, hi);
+    }
+
+    _mm_storeu_si128((__m128i*)Y, gcm_bswap(y));
+}
+
+// CTR encryption stitched with GHASH: the ciphertext of each group of 8 blocks is hashed in the same loop
+// iteration that encrypts the next group, so the aesenc and pclmulqdq chains are independent and overlap
+__attribute__((target("aes,pclmul,sse4.1,ssse3")))
+void aes_gcm::crypt_clmul(const uint8_t* J0, uint8_t* Y, const uint8_t* in, uint8_t* out, size_t len, bool encrypting) const
+{
+    const uint32_t num_rounds = cipher.num_rounds;
+    __m128i rk[15];
+    for (uint32_t i = 0; i <= num_rounds; ++i)
+        rk[i] = _mm_load_si128((const __m128i*)&cipher.round_keys[16*i]);
+
+    __m128i hp[8];
+    for (int i = 0; i < 8; ++i)
+        hp[i] = _mm_load_si128((const __m128i*)H_pow[i]);
+
+    __m128i y = gcm_bswap(_mm_loadu_si128((const __m128i*)Y));
+    __m128i base = _mm_loadu_si128((const __m128i*)J0);
+    uint32_t ctr = (((uint32_t)J0[12] << 24) | ((uint32_t)J0[13] << 16) | ((uint32_t)J0[14] << 8) | J0[15]) + 1;
+
+    // byte-reversed ciphertext of the previous group, waiting to be hashed
+    __m128i pending[8];
+    bool have_pending = false;
+
+    size_t offset = 0;
+    for (; offset + 128 <= len; offset += 128)
+    {
+        __m128i b[8];
+        for (int j = 0; j < 8; ++j)
+            b[j] = _mm_xor_si128(_mm_insert_epi32(base, (int)__builtin_bswap32(ctr + j), 3), rk[0]);
+        ctr += 8;
+
+        // when decrypting the input is the ciphertext, so this group can be hashed straight away
+        if (!encrypting)
+        {
+            for (int j = 0; j < 8; ++j)
+                pending[j] = gcm_bswap(_mm_loadu_si128((const __m128i*)(in + offset + 16*j)));
+            have_pending = true;
+        }
+
+        // both key sizes have at least 9 full rounds, one pending block is multiplied per round
+        if (have_pending)
+        {
+            __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+            pending[0] = _mm_xor_si128(pending[0], y);
+            for (uint32_t r = 1; r <= 8; ++r)
+            {
+                GV_AESENC_X8(_mm_aesenc_si128, b, rk[r]);
+                gcm_clmul_acc(pending[r - 1], hp[8 - r], lo, hi);
+            }
+            y = gcm_reduce(lo, hi);
+        }
+        else
+        {
+            for (uint32_t r = 1; r <= 8; ++r)
+            {
+                GV_AESENC_X8(_mm_aesenc_si128, b, rk[r]);
+            }
+        }
+        for (uint32_t r = 9; r < num_rounds; ++r)
+        {
+            GV_AESENC_X8(_mm_aesenc_si128, b, rk[r]);
+        }
+        GV_AESENC_X8(_mm_aesenclast_si128, b, rk[num_rounds]);
+
+        for (int j = 0; j < 8; ++j)
+        {
+            __m128i c = _mm_xor_si128(_mm_loadu_si128((const __m128i*)(in + offset + 16*j)), b[j]);
+            _mm_storeu_si128((__m128i*)(out + offset + 16*j), c);
+            if (encrypting)
+                pending[j] = gcm_bswap(c);
+        }
+        have_pending = encrypting;
+    }
+
+    // hash the final full group of ciphertext when encrypting
+    if (have_pending)
+    {
+        __m128i lo = _mm_setzero_si128(), hi = _mm_setzero_si128();
+        for (int j = 0; j < 8; ++j)
+            gcm_clmul_acc(j == 0 ? _mm_xor_si128(pending[0], y) : pending[j], hp[7 - j], lo, hi);
+        y = gcm_reduce(lo, hi);
+    }
+
+    _mm_storeu_si128((__m128i*)Y, gcm_bswap(y));
+
+    // tail of fewer than 8 blocks
+    if (offset < len)
+    {
+        uint8_t ctr_block[16];
+        std::memcpy(ctr_block, J0, 12);
+        ctr_block[12] = (uint8_t)(ctr >> 24); ctr_block[13] = (uint8_t)(ctr >> 16);
+        ctr_block[14] = (uint8_t)(ctr >> 8);  ctr_block[15] = (uint8_t)ctr;
+
+        if (!encrypting)
+            ghash_clmul(Y, in + offset, len - offset);
+        cipher.ctr_crypt_aesni(ctr_block, in + offset, out + offset, len - offset);
+        if (encrypting)
+            ghash_clmul(Y, out + offset, len - offset);
+    }
+}
+
+#undef GV_AESENC_X8
+
+#endif
+
+} // namespace gv
@@ -0,0 +1,167 @@
+#include <iostream>
+#include "aes.hpp"
+
+// GCM spec (McGrew and Viega) test cases 4, 6, 16 and 18: AES-128 and AES-256, each with the 12-byte iv
+// and with a 60-byte iv that goes through GHASH, and 20 bytes of aad
+struct gcm_vector
+{
+    const char* key;
+    const char* iv;
+    const char* ciphertext;
+    const char* tag;
+};
+
+const char* gcm_plaintext =
+    "d9313225f88406e5a55909c5aff5269a86a7a9531534f7da2e4c303d8a318a721c3c0c95956809532fcf0e2449a6b525b16aedf5aa0de657ba637b39";
+const char* gcm_aad = "feedfacedeadbeeffeedfacedeadbeefabaddad2";
+const char* gcm_long_iv =
+    "9313225df88406e555909c5aff5269aa6a7a9538534f7da1e4c303d2a318a728c3c0c95156809539fcf0e2429a6b525416aedbf5a0de6a57a637b39b";
+
+const char* gcm_key_256 = "feffe9928665731c6d6a8f9467308308feffe9928665731c6d6a8f9467308308";
+
+const gcm_vector gcm_vectors[] = {
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888",
+     "42831ec2217774244b7221b784d0d49ce3aa212f2c02a4e035c17e2329aca12e21d514b25466931c7d8f6a5aac84aa051ba30b396a0aac973d58e091",
+     "5bc94fbc3221a5db94fae95ae7121a47"},
+    {"feffe9928665731c6d6a8f9467308308", gcm_long_iv,
+     "8ce24998625615b603a033aca13fb894be9112a5c3a211a8ba262a3cca7e2ca701e4a9a4fba43c90ccdcb281d48c7c6fd62875d2aca417034c34aee5",
+     "619cc5aefffe0bfa462af43c1699d050"},
+    {gcm_key_256, "cafebabefacedbaddecaf888",
+     "522dc1f099567d07f47f37a32a84427d643a8cdcbfe5c0c97598a2bd2555d1aa8cb08e48590dbb3da7b08b1056828838c5f61e6393ba7a0abcc9f662",
+     "76fc6ece0f4e1768cddf8853bb2d551b"},
+    {gcm_key_256, gcm_long_iv,
+     "5a8def2f0c9e53f1f75d7853659e2a20eeb2b22aafde6419a058ab4f6f746bf40fc0c3b780f244452da3ebf1c5d82cdea2418997200ef82e44ae7e3f",
+     "a44a8266ee1c8eb0c8b5d4cf5ae9f19a"},
+};
+
+// longer messages, generated with OpenSSL (EVP_aes_128_gcm, EVP_aes_256_gcm), which run through the 8-block
+// AES-NI loop, and with the 200-byte aad through the 8-block GHASH; plaintext byte i is 7*i + 3, aad byte i is 11*i + 5
+struct gcm_long_vector
+{
+    const char* key;
+    const char* iv;
+    size_t aad_len;
+    size_t len;
+    const char* ciphertext;
+    const char* tag;
+};
+
+const gcm_long_vector gcm_long_vectors[] = {
+    {"feffe9928665731c6d6a8f9467308308", "cafebabefacedbaddecaf888", 60, 300,
+     "98b83dffc6d55ff5d56961227c7b976a167709f4b6a0ce9eb03ff7de6453fe80de03e9df3e08975b49624d4ed21c5a6cf99387a4af713744"
+     "0ca90208fa3e3e6c1e62b61c11145c0543abf659dd3eae4d25e2b5b98c9f7a5b48a5219c44fd71fd53b4ed071ae98d268beeee34e8c9747d"
+     "d2a7d59d4f50be34cfd8f3566174e2247d5c6c29779d09ab98bbff7b91bec02c334cdd8e2d53951eb9e1c1947c77f3771107376ed22f6925"
+     "9ae5373183bce37352669a294a3fca2d78fea7a2bdd1621ce7f955a6c5f7c4dad4464d3138c00b1e9d287febb5a56ef3a0101c388797b026"
+     "93b74fc9b65097f2ace31443323daf1f220a9b7138d14bd40d43c9caedcb5190226b1091efbf88997fcb45dc4fdd4084f218fbd3e39a0cbf"
+     "d7510a30be793d116df26ad037138511781ef574",
+     "7617dcbad0b7f5f06761a4d8f0907766"},
+    {gcm_key_256, "cafebabefacedbaddecaf888", 60, 260,
+     "8816e2cd7ef456d66a647736d22f018b91e7a4072547aab7f0662b4068aa8e04736673253363bf7a935dac04281a785127c692fe56c1e1d9"
+     "8d3814fb34817244a765aa8e3f0b90beb397870de1e6c5c3efa4affca440f46d30056456df4a8c69c4512530a5b25ea78ebd348d87c9c8a1"
+     "9394489741fd398be56172cf72e7912f3f13a0797b428097312c066ed8f6a9b3b9abc86ae0c2e7117c2449e17eb6db259f9b0aece78016a3"
+     "cab70ac07142b8479e85f8ba41ac8015fbfe04855bd3f2ee9b56744cf96161d6d6f00220711f4fe92474192597d5fb13a15c44b6c97d6f86"
+     "96d424dc9c8004ad6e8f15b98992dfdd74769ad6b134204a4bbe0c1fa35bc1b17e70c38d",
+     "4b682e7b1e1d5589657d56674939bfb7"},
+    {gcm_key_256, gcm_long_iv, 200, 129,
+     "80b6cc12eb3c7820694638c69d3569d61b6f9af1357c0e6725a622b2228b345af0163edaea9c4002194ecce5bb40dcb74071050ae57563fd"
+     "755f9ca6d208fabbe1260c5353fb852af9b4b12782d0bc5a3e79a98b5ca2e8ca80338a1b42db1b1ded95c1cc03fe06dba031475baa50522b"
+     "3db720a79b17c65c077df459e514bc1ec3",
+     "b60217694151e5262965db0f879d127d"},
+};
+
+std::string byte_pattern(size_t len, int mul, int add)
+{
+    std::string out(len, 0);
+    for (size_t i = 0; i < len; ++i)
+        out[i] = (char)(i * mul + add);
+    return out;
+}
+
+// encrypts, decrypts, and checks that a modified tag is rejected
+int check_gcm(const std::string& key, const std::string& iv, const std::string& aad, const std::string& plaintext, const std::string& expected)
+{
+    gv::aes_gcm gcm(key);
+    int num_wrong = 0;
+
+    std::string sealed = gv::bytes_to_hexcode(gcm.encrypt(iv, plaintext, aad));
+    if (sealed != expected) {
+        std::cout << "GCM, " << key.size() << "-byte key, " << iv.size() << "-byte iv, " << plaintext.size() << " bytes: "
+                  << sealed << " (should be " << expected << ")" << std::endl;
+        ++num_wrong;
+    }
+
+    std::string opened, forged_opened;
+    std::string sealed_bytes = gv::hexcode_to_bytes(expected);
+    std::string forged = sealed_bytes;
+    forged.back() ^= 1;
+    if (!gcm.decrypt(iv, sealed_bytes, opened, aad) || opened != plaintext || gcm.decrypt(iv, forged, forged_opened, aad)) {
+        std::cout << "GCM, " << plaintext.size() << " bytes: decryption failed or accepted a modified tag" << std::endl;
+        ++num_wrong;
+    }
+    return num_wrong;
+}
+
+int main(int argc, char* argv[]) {
+    // FIPS-197 appendix C.1 and C.3 example vectors
+    std::string block = gv::hexcode_to_bytes("00112233445566778899aabbccddeeff");
+    gv::aes cipher_128(gv::hexcode_to_bytes("000102030405060708090a0b0c0d0e0f"));
+    gv::aes cipher_256(gv::hexcode_to_bytes("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+
+    uint8_t out_128[16], out_256[16];
+    cipher_128.encrypt_block((const uint8_t*)block.data(), out_128);
+    cipher_256.encrypt_block((const uint8_t*)block.data(), out_256);
+    std::string block_128 = gv::bytes_to_hexcode(std::string((char*)out_128, 16));
+    std::string block_256 = gv::bytes_to_hexcode(std::string((char*)out_256, 16));
+
+    std::cout << "AES-128 block: " << block_128 << " (should be 69c4e0d86a7b0430d8cdb78070b4c55a)" << std::endl;
+    std::cout << "AES-256 block: " << block_256 << " (should be 8ea2b7ca516745bfeafc49904b496089)" << std::endl;
+
+    // CTR over several batches of blocks against one block at a time
+    std::string counter = gv::hexcode_to_bytes("f0f1f2f3f4f5f6f7f8f9fafbfcfdfeff");
+    std::string message(1000, 0);
+    for (size_t i = 0; i < message.size(); ++i)
+        message[i] = (char)(i * 131);
+
+    std::string ctr_out = cipher_256.ctr(counter, message);
+    std::string ctr_block = counter;
+    bool ctr_ok = true;
+    for (size_t offset = 0; offset < message.size(); offset += 16) {
+        uint8_t keystream[16];
+        cipher_256.encrypt_block((const uint8_t*)ctr_block.data(), keystream);
+        gv::aes_inc32((uint8_t*)&ctr_block[0]);
+        for (size_t i = offset; i < message.size() && i < offset + 16; ++i)
+            ctr_ok = ctr_ok && ctr_out[i] == (char)(message[i] ^ keystream[i - offset]);
+    }
+    std::cout << "CTR: " << (ctr_ok ? "matches" : "DIFFERS from") << " the block cipher (should be matches)" << std::endl;
+
+    // GCM encryption, decryption, and rejection of a modified tag
+    std::string plaintext = gv::hexcode_to_bytes(gcm_plaintext);
+    std::string aad = gv::hexcode_to_bytes(gcm_aad);
+
+    int num_wrong = 0;
+    for (const gcm_vector& v : gcm_vectors)
+        num_wrong += check_gcm(gv::hexcode_to_bytes(v.key), gv::hexcode_to_bytes(v.iv), aad, plaintext, std::string(v.ciphertext) + v.tag);
+    for (const gcm_long_vector& v : gcm_long_vectors)
+        num_wrong += check_gcm(gv::hexcode_to_bytes(v.key), gv::hexcode_to_bytes(v.iv), byte_pattern(v.aad_len, 11, 5),
+                               byte_pattern(v.len, 7, 3), std::string(v.ciphertext) + v.tag);
+    std::cout << "GCM test cases: " << num_wrong << " wrong" << std::endl;
+
+    // encrypt and decrypt the input with AES-256-GCM under a fixed demo key and iv
+    if (argc > 1) {
+        std::string input(argv[1]);
+
+        gv::aes_gcm gcm(gv::hexcode_to_bytes("000102030405060708090a0b0c0d0e0f101112131415161718191a1b1c1d1e1f"));
+        std::string iv = gv::hexcode_to_bytes("cafebabefacedbaddecaf888");
+
+        std::string ciphertext = gcm.encrypt(iv, input);
+        std::string decrypted;
+        bool ok = gcm.decrypt(iv, ciphertext, decrypted);
+
+        std::cout << input << " >>>> AES-256-GCM >>>> " << gv::bytes_to_hexcode(ciphertext) << std::endl;
+        std::cout << (ok ? decrypted : "authentication failed") << std::endl;
+    }
+
+    bool ok = block_128 == "69c4e0d86a7b0430d8cdb78070b4c55a" && block_256 == "8ea2b7ca516745bfeafc49904b496089"
+              && ctr_ok && num_wrong == 0;
+    return ok ? 0 : 1;
+}
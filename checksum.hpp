@@ -0,0 +1,867 @@
+#pragma once
+/*
+    Fast non-cryptographic checksums
+
+    William Denny
+
+    - CRC32C (Castagnoli polynomial 0x1EDC6F41), as used by iSCSI, ext4 and SCTP
+        - SSE4.2 crc32 instruction on three interleaved streams, merged with PCLMULQDQ
+        - slicing-by-8 tables otherwise
+        - crc32c::combine gives the checksum of two concatenated ranges from their checksums
+
+    - XXH3 (64 and 128-bit), following the xxHash reference specification
+        - AVX2 accumulation of long inputs
+
+    These detect accidental corruption (torn writes, bit flips) only. They are easy to forge,
+    so use a SHA function wherever an attacker can choose the data.
+
+*/
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <string_view>
+#include <array>
+#include <cstring>
+#include <assert.h>
+
+#include "crypto_useful.hpp"
+
+namespace gv
+{
+
+// **************************************************************************************************************
+// CRC32C
+// **************************************************************************************************************
+
+namespace crc32c
+{
+
+// reversed (bit-reflected) form of the polynomial, bit i holds the coefficient of x^(31-i)
+const uint32_t poly = 0x82f63b78;
+
+// FUNCTION DECLARATIONS
+
+// checksum of len bytes, continuing from the checksum crc of any preceding data
+uint32_t checksum(const uint8_t* data, size_t len, uint32_t crc = 0);
+uint32_t checksum(std::string_view str, uint32_t crc = 0);
+
+// checksum of A followed by B, given the checksums of A and B and the length of B
+// e.g. combine(checksum(a), checksum(b), b.size()) == checksum(a + b)
+uint32_t combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b);
+
+// checksums each string, the hardware backend interleaves three strings at a time
+std::vector<uint32_t> checksum_batch(const std::vector<std::string>& strs);
+
+// polynomial arithmetic modulo the CRC polynomial, in the reflected representation
+constexpr uint32_t multmodp(uint32_t a, uint32_t b);
+constexpr uint32_t xpow(uint64_t n);
+
+uint32_t checksum_portable(uint32_t crc, const uint8_t* data, size_t len);
+
+#ifdef GV_X86_DISPATCH
+uint32_t checksum_sse42(uint32_t crc, const uint8_t* data, size_t len);
+uint32_t checksum_sse42_clmul(uint32_t crc, const uint8_t* data, size_t len);
+
+// continues the registers of three strings over their first len bytes, len must be a multiple of 8
+void checksum_x3_sse42(uint32_t crc[3], const uint8_t* const data[3], size_t len);
+#endif
+
+//********************************************************************************************************************
+
+// a(x) * b(x) mod P(x)
+constexpr uint32_t multmodp(uint32_t a, uint32_t b)
+{
+    uint32_t p = 0;
+    for (uint32_t m = (uint32_t)1 << 31; m != 0; m >>= 1)
+    {
+        if (a & m)
+            p ^= b;
+
+        // b = b(x) * x mod P(x)
+        b = (b & 1) ? (b >> 1) ^ poly : b >> 1;
+    }
+    return p;
+}
+
+// x^n mod P(x), by repeated squaring
+constexpr uint32_t xpow(uint64_t n)
+{
+    uint32_t p = (uint32_t)1 << 31;   // x^0
+    uint32_t sq = (uint32_t)1 << 30;  // x^1
+    for (; n != 0; n >>= 1)
+    {
+        if (n & 1)
+            p = multmodp(sq, p);
+        sq = multmodp(sq, sq);
+    }
+    return p;
+}
+
+// slicing-by-8 tables, table[k][b] is the CRC of byte b followed by k zero bytes
+constexpr std::array<std::array<uint32_t, 256>, 8> make_tables()
+{
+    std::array<std::array<uint32_t, 256>, 8> table = {};
+    for (uint32_t b = 0; b < 256; ++b)
+    {
+        uint32_t c = b;
+        for (int i = 0; i < 8; ++i)
+            c = (c & 1) ? (c >> 1) ^ poly : c >> 1;
+        table[0][b] = c;
+    }
+    for (int k = 1; k < 8; ++k)
+        for (uint32_t b = 0; b < 256; ++b)
+            table[k][b] = (table[k - 1][b] >> 8) ^ table[0][table[k - 1][b] & 0xff];
+    return table;
+}
+
+constexpr std::array<std::array<uint32_t, 256>, 8> tables = make_tables();
+
+// the checksum is inverted before and after the data, so the register is worked on as ~crc
+uint32_t checksum(const uint8_t* data, size_t len, uint32_t crc)
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().sse42 && cpu().pclmul)
+        return ~checksum_sse42_clmul(~crc, data, len);
+    if (cpu().sse42)
+        return ~checksum_sse42(~crc, data, len);
+#endif
+    return ~checksum_portable(~crc, data, len);
+}
+
+uint32_t checksum(std::string_view str, uint32_t crc)
+{
+    return checksum((const uint8_t*)str.data(), str.size(), crc);
+}
+
+// appending len_b bytes multiplies the register by x^(8 len_b), the inversions cancel out
+uint32_t combine(uint32_t crc_a, uint32_t crc_b, uint64_t len_b)
+{
+    return multmodp(xpow(8*len_b), crc_a) ^ crc_b;
+}
+
+uint32_t checksum_portable(uint32_t crc, const uint8_t* data, size_t len)
+{
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint32_t lo = crc ^ load_le<uint32_t>(data);
+        uint32_t hi = load_le<uint32_t>(data + 4);
+        crc = tables[7][lo & 0xff] ^ tables[6][(lo >> 8) & 0xff] ^ tables[5][(lo >> 16) & 0xff] ^ tables[4][lo >> 24]
+            ^ tables[3][hi & 0xff] ^ tables[2][(hi >> 8) & 0xff] ^ tables[1][(hi >> 16) & 0xff] ^ tables[0][hi >> 24];
+    }
+    for (; len > 0; ++data, --len)
+        crc = (crc >> 8) ^ tables[0][(crc ^ *data) & 0xff];
+    return crc;
+}
+
+std::vector<uint32_t> checksum_batch(const std::vector<std::string>& strs)
+{
+    std::vector<uint32_t> out(strs.size());
+    size_t i = 0;
+
+#ifdef GV_X86_DISPATCH
+    if (cpu().sse42)
+    {
+        // three strings at a time, up to the length of the shortest, hides the 3 cycle latency of crc32
+        for (; i + 3 <= strs.size(); i += 3)
+        {
+            const uint8_t* p[3];
+            size_t common = strs[i].size();
+            for (int s = 0; s < 3; ++s)
+            {
+                p[s] = (const uint8_t*)strs[i + s].data();
+                if (strs[i + s].size() < common)
+                    common = strs[i + s].size();
+            }
+            common -= common % 8;
+
+            uint32_t c[3] = {0xffffffff, 0xffffffff, 0xffffffff};
+            checksum_x3_sse42(c, p, common);
+
+            for (int s = 0; s < 3; ++s)
+                out[i + s] = checksum(p[s] + common, strs[i + s].size() - common, ~c[s]);
+        }
+    }
+#endif
+
+    for (; i < strs.size(); ++i)
+        out[i] = checksum(strs[i]);
+    return out;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// bytes per stream when interleaving, checked from longest to shortest
+const size_t long_stream = 8192;
+const size_t short_stream = 256;
+
+// crc32 on one 8-byte word has a latency of 3 cycles but a throughput of 1 per cycle
+// so a single stream runs at a third of the possible speed
+__attribute__((target("sse4.2")))
+uint32_t checksum_sse42(uint32_t crc, const uint8_t* data, size_t len)
+{
+    uint64_t c = crc;
+    for (; len >= 8; data += 8, len -= 8)
+    {
+        uint64_t word;
+        std::memcpy(&word, data, 8);
+        c = _mm_crc32_u64(c, word);
+    }
+    for (; len > 0; ++data, --len)
+        c = _mm_crc32_u8((uint32_t)c, *data);
+    return (uint32_t)c;
+}
+
+__attribute__((target("sse4.2")))
+void checksum_x3_sse42(uint32_t crc[3], const uint8_t* const data[3], size_t len)
+{
+    uint64_t c0 = crc[0], c1 = crc[1], c2 = crc[2];
+    for (size_t k = 0; k < len; k += 8)
+    {
+        uint64_t w0, w1, w2;
+        std::memcpy(&w0, data[0] + k, 8);
+        std::memcpy(&w1, data[1] + k, 8);
+        std::memcpy(&w2, data[2] + k, 8);
+        c0 = _mm_crc32_u64(c0, w0);
+        c1 = _mm_crc32_u64(c1, w1);
+        c2 = _mm_crc32_u64(c2, w2);
+    }
+    crc[0] = (uint32_t)c0;
+    crc[1] = (uint32_t)c1;
+    crc[2] = (uint32_t)c2;
+}
+
+// multiplies the register by x^n mod P, where k = x^(n - 33) mod P
+// the carry-less product of two reflected 32-bit values is a 64-bit value times x, and crc32 of a
+// 64-bit word with a zero register reduces it times x^32
+__attribute__((target("sse4.2,pclmul")))
+inline uint64_t shift_clmul(uint64_t c, uint32_t k)
+{
+    __m128i product = _mm_clmulepi64_si128(_mm_cvtsi32_si128((int)c), _mm_cvtsi32_si128((int)k), 0x00);
+    return _mm_crc32_u64(0, (uint64_t)_mm_cvtsi128_si64(product));
+}
+
+// three independent streams of stream bytes each, started from c, 0 and 0
+// merged as c0 * x^(16 stream) + c1 * x^(8 stream) + c2
+#define GV_CRC32C_X3(stream, k) \
+    while (len >= 3*stream) \
+    { \
+        uint64_t c0 = c, c1 = 0, c2 = 0; \
+        for (const uint8_t* end = data + stream; data < end; data += 8) \
+        { \
+            uint64_t w0, w1, w2; \
+            std::memcpy(&w0, data, 8); \
+            std::memcpy(&w1, data + stream, 8); \
+            std::memcpy(&w2, data + 2*stream, 8); \
+            c0 = _mm_crc32_u64(c0, w0); \
+            c1 = _mm_crc32_u64(c1, w1); \
+            c2 = _mm_crc32_u64(c2, w2); \
+        } \
+        c = shift_clmul(shift_clmul(c0, k) ^ c1, k) ^ c2; \
+        data += 2*stream; \
+        len -= 3*stream; \
+    }
+
+__attribute__((target("sse4.2,pclmul")))
+uint32_t checksum_sse42_clmul(uint32_t crc, const uint8_t* data, size_t len)
+{
+    static constexpr uint32_t k_long = xpow(8*long_stream - 33);
+    static constexpr uint32_t k_short = xpow(8*short_stream - 33);
+
+    uint64_t c = crc;
+    GV_CRC32C_X3(long_stream, k_long)
+    GV_CRC32C_X3(short_stream, k_short)
+    return checksum_sse42((uint32_t)c, data, len);
+}
+
+#undef GV_CRC32C_X3
+
+#endif
+
+} // namespace crc32c
+
+// **************************************************************************************************************
+// XXH3
+// **************************************************************************************************************
+
+namespace xxh3
+{
+
+// DATATYPES
+
+struct hash128_t
+{
+    uint64_t low;
+    uint64_t high;
+
+    bool operator==(const hash128_t& other) const { return low == other.low && high == other.high; }
+    bool operator!=(const hash128_t& other) const { return !(*this == other); }
+};
+
+// CONSTANTS
+
+const uint64_t prime32_1 = 0x9e3779b1;
+const uint64_t prime32_2 = 0x85ebca77;
+const uint64_t prime32_3 = 0xc2b2ae3d;
+const uint64_t prime64_1 = 0x9e3779b185ebca87;
+const uint64_t prime64_2 = 0xc2b2ae3d27d4eb4f;
+const uint64_t prime64_3 = 0x165667b19e3779f9;
+const uint64_t prime64_4 = 0x85ebca77c2b2ae63;
+const uint64_t prime64_5 = 0x27d4eb2f165667c5;
+const uint64_t prime_mx1 = 0x165667919e3779f9;
+const uint64_t prime_mx2 = 0x9fb21c651e98df25;
+
+// inputs are processed as 64-byte stripes, each consuming 8 more bytes of the secret
+// 16 stripes make a block, after which the accumulators are scrambled
+const size_t secret_bytes = 192;
+const size_t stripe_bytes = 64;
+const size_t stripes_per_block = (secret_bytes - stripe_bytes) / 8;
+const size_t block_bytes = stripe_bytes * stripes_per_block;
+
+// inputs up to this length take the short paths, which do not use the accumulators
+const size_t midsize_max = 240;
+
+// pseudorandom default secret
+alignas(64) const uint8_t default_secret[secret_bytes] = {
+    0xb8, 0xfe, 0x6c, 0x39, 0x23, 0xa4, 0x4b, 0xbe, 0x7c, 0x01, 0x81, 0x2c, 0xf7, 0x21, 0xad, 0x1c,
+    0xde, 0xd4, 0x6d, 0xe9, 0x83, 0x90, 0x97, 0xdb, 0x72, 0x40, 0xa4, 0xa4, 0xb7, 0xb3, 0x67, 0x1f,
+    0xcb, 0x79, 0xe6, 0x4e, 0xcc, 0xc0, 0xe5, 0x78, 0x82, 0x5a, 0xd0, 0x7d, 0xcc, 0xff, 0x72, 0x21,
+    0xb8, 0x08, 0x46, 0x74, 0xf7, 0x43, 0x24, 0x8e, 0xe0, 0x35, 0x90, 0xe6, 0x81, 0x3a, 0x26, 0x4c,
+    0x3c, 0x28, 0x52, 0xbb, 0x91, 0xc3, 0x00, 0xcb, 0x88, 0xd0, 0x65, 0x8b, 0x1b, 0x53, 0x2e, 0xa3,
+    0x71, 0x64, 0x48, 0x97, 0xa2, 0x0d, 0xf9, 0x4e, 0x38, 0x19, 0xef, 0x46, 0xa9, 0xde, 0xac, 0xd8,
+    0xa8, 0xfa, 0x76, 0x3f, 0xe3, 0x9c, 0x34, 0x3f, 0xf9, 0xdc, 0xbb, 0xc7, 0xc7, 0x0b, 0x4f, 0x1d,
+    0x8a, 0x51, 0xe0, 0x4b, 0xcd, 0xb4, 0x59, 0x31, 0xc8, 0x9f, 0x7e, 0xc9, 0xd9, 0x78, 0x73, 0x64,
+    0xea, 0xc5, 0xac, 0x83, 0x34, 0xd3, 0xeb, 0xc3, 0xc5, 0x81, 0xa0, 0xff, 0xfa, 0x13, 0x63, 0xeb,
+    0x17, 0x0d, 0xdd, 0x51, 0xb7, 0xf0, 0xda, 0x49, 0xd3, 0x16, 0x55, 0x26, 0x29, 0xd4, 0x68, 0x9e,
+    0x2b, 0x16, 0xbe, 0x58, 0x7d, 0x47, 0xa1, 0xfc, 0x8f, 0xf8, 0xb8, 0xd1, 0x7a, 0xd0, 0x31, 0xce,
+    0x45, 0xcb, 0x3a, 0x8f, 0x95, 0x16, 0x04, 0x28, 0xaf, 0xd7, 0xfb, 0xca, 0xbb, 0x4b, 0x40, 0x7e,
+};
+
+// FUNCTION DECLARATIONS
+
+// main hash fcns, the seed selects an independent hash function
+uint64_t hash64(const uint8_t* data, size_t len, uint64_t seed = 0);
+uint64_t hash64(std::string_view str, uint64_t seed = 0);
+hash128_t hash128(const uint8_t* data, size_t len, uint64_t seed = 0);
+hash128_t hash128(std::string_view str, uint64_t seed = 0);
+
+// long inputs (> midsize_max bytes)
+void accumulate(uint64_t acc[8], const uint8_t* input, const uint8_t* secret, size_t num_stripes);
+void scramble(uint64_t acc[8], const uint8_t* secret);
+void accumulate_stripe(uint64_t acc[8], const uint8_t* stripe, const uint8_t* secret);
+
+#ifdef GV_X86_DISPATCH
+void accumulate_avx2(uint64_t acc[8], const uint8_t* input, const uint8_t* secret, size_t num_stripes);
+void scramble_avx2(uint64_t acc[8], const uint8_t* secret);
+#endif
+
+//********************************************************************************************************************
+
+// streaming XXH3, for data that arrives in pieces
+// gives the same results as hash64 and hash128 of the whole input
+class context
+{
+
+public:
+    context(uint64_t seed = 0);
+
+    void update(const uint8_t* data, size_t len);
+    void update(std::string_view str) { update((const uint8_t*)str.data(), str.size()); }
+
+    // hash of everything so far, the context can still be updated afterwards
+    uint64_t digest64() const;
+    hash128_t digest128() const;
+
+private:
+    // stripes are only consumed once more input follows them, because the final stripe is
+    // hashed differently. The buffer also keeps the last stripe consumed, which the final
+    // stripe may overlap
+    static const size_t buffer_bytes = 256;
+
+    alignas(64) uint64_t acc[8];
+    alignas(64) uint8_t secret[secret_bytes];
+    alignas(64) uint8_t buffer[buffer_bytes];
+    size_t buffered = 0;
+    size_t stripes_so_far = 0;
+    uint64_t total_len = 0;
+    uint64_t seed;
+
+    void consume_stripes(uint64_t acc[8], size_t& stripes_so_far, const uint8_t* input, size_t num_stripes) const;
+    void digest_long(uint64_t acc[8]) const;
+};
+
+//********************************************************************************************************************
+
+// HELPER FCNS
+
+// full 64 x 64 -> 128-bit product
+inline hash128_t mul128(uint64_t a, uint64_t b)
+{
+#ifdef __SIZEOF_INT128__
+    unsigned __int128 product = (unsigned __int128)a * b;
+    return {(uint64_t)product, (uint64_t)(product >> 64)};
+#else
+    uint64_t lo_lo = (a & 0xffffffff) * (b & 0xffffffff);
+    uint64_t hi_lo = (a >> 32) * (b & 0xffffffff);
+    uint64_t lo_hi = (a & 0xffffffff) * (b >> 32);
+    uint64_t hi_hi = (a >> 32) * (b >> 32);
+    uint64_t cross = (lo_lo >> 32) + (hi_lo & 0xffffffff) + lo_hi;
+    return {(cross << 32) | (lo_lo & 0xffffffff), (hi_lo >> 32) + (cross >> 32) + hi_hi};
+#endif
+}
+
+// xors the halves of the 128-bit product
+inline uint64_t mul128_fold64(uint64_t a, uint64_t b)
+{
+    hash128_t product = mul128(a, b);
+    return product.low ^ product.high;
+}
+
+inline uint64_t xorshift(uint64_t x, int shift)
+{
+    return x ^ (x >> shift);
+}
+
+// final mixing steps, make every output bit depend on every input bit
+inline uint64_t xxh64_avalanche(uint64_t h)
+{
+    h = xorshift(h, 33) * prime64_2;
+    h = xorshift(h, 29) * prime64_3;
+    return xorshift(h, 32);
+}
+
+inline uint64_t avalanche(uint64_t h)
+{
+    return xorshift(xorshift(h, 37) * prime_mx1, 32);
+}
+
+inline uint64_t rrmxmx(uint64_t h, uint64_t len)
+{
+    h ^= circ_left_shift(h, 49) ^ circ_left_shift(h, 24);
+    h *= prime_mx2;
+    h ^= (h >> 35) + len;
+    h *= prime_mx2;
+    return xorshift(h, 28);
+}
+
+inline uint64_t mix16(const uint8_t* input, const uint8_t* secret, uint64_t seed)
+{
+    return mul128_fold64(load_le<uint64_t>(input) ^ (load_le<uint64_t>(secret) + seed), load_le<uint64_t>(input + 8) ^ (load_le<uint64_t>(secret + 8) - seed));
+}
+
+inline hash128_t mix32(hash128_t acc, const uint8_t* input_1, const uint8_t* input_2, const uint8_t* secret, uint64_t seed)
+{
+    acc.low += mix16(input_1, secret, seed);
+    acc.low ^= load_le<uint64_t>(input_2) + load_le<uint64_t>(input_2 + 8);
+    acc.high += mix16(input_2, secret + 16, seed);
+    acc.high ^= load_le<uint64_t>(input_1) + load_le<uint64_t>(input_1 + 8);
+    return acc;
+}
+
+// the default secret with the seed added to its even words and subtracted from its odd words
+void seeded_secret(uint8_t secret[secret_bytes], uint64_t seed)
+{
+    for (size_t i = 0; i < secret_bytes; i += 16)
+    {
+        store_le<uint64_t>(secret + i, load_le<uint64_t>(default_secret + i) + seed);
+        store_le<uint64_t>(secret + i + 8, load_le<uint64_t>(default_secret + i + 8) - seed);
+    }
+}
+
+// SHORT INPUTS (<= 240 bytes)
+
+uint64_t hash64_short(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed)
+{
+    if (len == 0)
+        return xxh64_avalanche(seed ^ load_le<uint64_t>(secret + 56) ^ load_le<uint64_t>(secret + 64));
+
+    if (len <= 3)
+    {
+        uint32_t combined = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | input[len - 1] | ((uint32_t)len << 8);
+        uint64_t bitflip = (load_le<uint32_t>(secret) ^ load_le<uint32_t>(secret + 4)) + seed;
+        return xxh64_avalanche(combined ^ bitflip);
+    }
+
+    if (len <= 8)
+    {
+        seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+        uint64_t bitflip = (load_le<uint64_t>(secret + 8) ^ load_le<uint64_t>(secret + 16)) - seed;
+        uint64_t input64 = load_le<uint32_t>(input + len - 4) + ((uint64_t)load_le<uint32_t>(input) << 32);
+        return rrmxmx(input64 ^ bitflip, len);
+    }
+
+    if (len <= 16)
+    {
+        uint64_t input_lo = load_le<uint64_t>(input) ^ ((load_le<uint64_t>(secret + 24) ^ load_le<uint64_t>(secret + 32)) + seed);
+        uint64_t input_hi = load_le<uint64_t>(input + len - 8) ^ ((load_le<uint64_t>(secret + 40) ^ load_le<uint64_t>(secret + 48)) - seed);
+        return avalanche(len + __builtin_bswap64(input_lo) + input_hi + mul128_fold64(input_lo, input_hi));
+    }
+
+    uint64_t acc = len * prime64_1;
+
+    // 17 to 128 bytes, 16-byte chunks from both ends
+    if (len <= 128)
+    {
+        for (size_t i = (len - 1) / 32 + 1; i-- > 0;)
+        {
+            acc += mix16(input + 16*i, secret + 32*i, seed);
+            acc += mix16(input + len - 16*(i + 1), secret + 32*i + 16, seed);
+        }
+        return avalanche(acc);
+    }
+
+    // 129 to 240 bytes
+    for (size_t i = 0; i < 8; ++i)
+        acc += mix16(input + 16*i, secret + 16*i, seed);
+    acc = avalanche(acc);
+
+    uint64_t acc_end = mix16(input + len - 16, secret + 136 - 17, seed);
+    for (size_t i = 8; i < len / 16; ++i)
+        acc_end += mix16(input + 16*i, secret + 16*(i - 8) + 3, seed);
+    return avalanche(acc + acc_end);
+}
+
+hash128_t hash128_short(const uint8_t* input, size_t len, const uint8_t* secret, uint64_t seed)
+{
+    if (len == 0)
+        return {xxh64_avalanche(seed ^ load_le<uint64_t>(secret + 64) ^ load_le<uint64_t>(secret + 72)),
+                xxh64_avalanche(seed ^ load_le<uint64_t>(secret + 80) ^ load_le<uint64_t>(secret + 88))};
+
+    if (len <= 3)
+    {
+        uint32_t combined_lo = ((uint32_t)input[0] << 16) | ((uint32_t)input[len >> 1] << 24) | input[len - 1] | ((uint32_t)len << 8);
+        uint32_t combined_hi = circ_left_shift(__builtin_bswap32(combined_lo), 13);
+        uint64_t bitflip_lo = (load_le<uint32_t>(secret) ^ load_le<uint32_t>(secret + 4)) + seed;
+        uint64_t bitflip_hi = (load_le<uint32_t>(secret + 8) ^ load_le<uint32_t>(secret + 12)) - seed;
+        return {xxh64_avalanche(combined_lo ^ bitflip_lo), xxh64_avalanche(combined_hi ^ bitflip_hi)};
+    }
+
+    if (len <= 8)
+    {
+        seed ^= (uint64_t)__builtin_bswap32((uint32_t)seed) << 32;
+        uint64_t input64 = load_le<uint32_t>(input) + ((uint64_t)load_le<uint32_t>(input + len - 4) << 32);
+        uint64_t bitflip = (load_le<uint64_t>(secret + 16) ^ load_le<uint64_t>(secret + 24)) + seed;
+        hash128_t m = mul128(input64 ^ bitflip, prime64_1 + (len << 2));
+        m.high += m.low << 1;
+        m.low ^= m.high >> 3;
+        m.low = xorshift(xorshift(m.low, 35) * prime_mx2, 28);
+        m.high = avalanche(m.high);
+        return m;
+    }
+
+    if (len <= 16)
+    {
+        uint64_t bitflip_lo = (load_le<uint64_t>(secret + 32) ^ load_le<uint64_t>(secret + 40)) - seed;
+        uint64_t bitflip_hi = (load_le<uint64_t>(secret + 48) ^ load_le<uint64_t>(secret + 56)) + seed;
+        uint64_t input_lo = load_le<uint64_t>(input);
+        uint64_t input_hi = load_le<uint64_t>(input + len - 8);
+        hash128_t m = mul128(input_lo ^ input_hi ^ bitflip_lo, prime64_1);
+        m.low += (uint64_t)(len - 1) << 54;
+        input_hi ^= bitflip_hi;
+        m.high += input_hi + (uint64_t)(uint32_t)input_hi * (prime32_2 - 1);
+        m.low ^= __builtin_bswap64(m.high);
+
+        hash128_t h = mul128(m.low, prime64_2);
+        h.high += m.high * prime64_2;
+        return {avalanche(h.low), avalanche(h.high)};
+    }
+
+    hash128_t acc = {len * prime64_1, 0};
+
+    if (len <= 128)
+    {
+        // 17 to 128 bytes, 16-byte chunks from both ends
+        for (size_t i = (len - 1) / 32 + 1; i-- > 0;)
+            acc = mix32(acc, input + 16*i, input + len - 16*(i + 1), secret + 32*i, seed);
+    }
+    else
+    {
+        // 129 to 240 bytes
+        for (size_t i = 32; i < 160; i += 32)
+            acc = mix32(acc, input + i - 32, input + i - 16, secret + i - 32, seed);
+        acc.low = avalanche(acc.low);
+        acc.high = avalanche(acc.high);
+        for (size_t i = 160; i <= len; i += 32)
+            acc = mix32(acc, input + i - 32, input + i - 16, secret + 3 + i - 160, seed);
+        acc = mix32(acc, input + len - 16, input + len - 32, secret + 136 - 17 - 16, 0 - seed);
+    }
+
+    hash128_t h;
+    h.low = avalanche(acc.low + acc.high);
+    h.high = 0 - avalanche(acc.low * prime64_1 + acc.high * prime64_4 + (len - seed) * prime64_2);
+    return h;
+}
+
+// LONG INPUTS (> 240 bytes)
+
+const uint64_t init_acc[8] = {prime32_3, prime64_1, prime64_2, prime64_3, prime64_4, prime32_2, prime64_5, prime32_1};
+
+// each 64-bit lane of the stripe is mixed with the secret and multiplied 32 x 32 -> 64 into its accumulator
+// and also added unmixed to its neighbour, so that no input is lost when the multiplication is by zero
+void accumulate_stripe(uint64_t acc[8], const uint8_t* stripe, const uint8_t* secret)
+{
+    for (int i = 0; i < 8; ++i)
+    {
+        uint64_t data = load_le<uint64_t>(stripe + 8*i);
+        uint64_t key = data ^ load_le<uint64_t>(secret + 8*i);
+        acc[i ^ 1] += data;
+        acc[i] += (key & 0xffffffff) * (key >> 32);
+    }
+}
+
+void accumulate(uint64_t acc[8], const uint8_t* input, const uint8_t* secret, size_t num_stripes)
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().avx2)
+        return accumulate_avx2(acc, input, secret, num_stripes);
+#endif
+    for (size_t n = 0; n < num_stripes; ++n)
+        accumulate_stripe(acc, input + stripe_bytes*n, secret + 8*n);
+}
+
+void scramble(uint64_t acc[8], const uint8_t* secret)
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().avx2)
+        return scramble_avx2(acc, secret);
+#endif
+    for (int i = 0; i < 8; ++i)
+        acc[i] = (xorshift(acc[i], 47) ^ load_le<uint64_t>(secret + 8*i)) * prime32_1;
+}
+
+// the last stripe is always the final 64 bytes of the input, and may overlap the previous stripe
+void hash_long(uint64_t acc[8], const uint8_t* input, size_t len, const uint8_t* secret)
+{
+    std::memcpy(acc, init_acc, sizeof(init_acc));
+
+    size_t num_blocks = (len - 1) / block_bytes;
+    for (size_t n = 0; n < num_blocks; ++n)
+    {
+        accumulate(acc, input + block_bytes*n, secret, stripes_per_block);
+        scramble(acc, secret + secret_bytes - stripe_bytes);
+    }
+
+    size_t num_stripes = ((len - 1) - block_bytes*num_blocks) / stripe_bytes;
+    accumulate(acc, input + block_bytes*num_blocks, secret, num_stripes);
+    accumulate_stripe(acc, input + len - stripe_bytes, secret + secret_bytes - stripe_bytes - 7);
+}
+
+uint64_t merge_accs(const uint64_t acc[8], const uint8_t* secret, uint64_t start)
+{
+    uint64_t result = start;
+    for (int i = 0; i < 4; ++i)
+        result += mul128_fold64(acc[2*i] ^ load_le<uint64_t>(secret + 16*i), acc[2*i + 1] ^ load_le<uint64_t>(secret + 16*i + 8));
+    return avalanche(result);
+}
+
+uint64_t digest64_long(const uint64_t acc[8], uint64_t len, const uint8_t* secret)
+{
+    return merge_accs(acc, secret + 11, len * prime64_1);
+}
+
+hash128_t digest128_long(const uint64_t acc[8], uint64_t len, const uint8_t* secret)
+{
+    return {merge_accs(acc, secret + 11, len * prime64_1),
+            merge_accs(acc, secret + secret_bytes - 64 - 11, ~(len * prime64_2))};
+}
+
+// MAIN HASH FCNS
+
+uint64_t hash64(const uint8_t* data, size_t len, uint64_t seed)
+{
+    if (len <= midsize_max)
+        return hash64_short(data, len, default_secret, seed);
+
+    alignas(64) uint64_t acc[8];
+    alignas(64) uint8_t secret[secret_bytes];
+    seeded_secret(secret, seed);
+    hash_long(acc, data, len, secret);
+    return digest64_long(acc, len, secret);
+}
+
+uint64_t hash64(std::string_view str, uint64_t seed)
+{
+    return hash64((const uint8_t*)str.data(), str.size(), seed);
+}
+
+hash128_t hash128(const uint8_t* data, size_t len, uint64_t seed)
+{
+    if (len <= midsize_max)
+        return hash128_short(data, len, default_secret, seed);
+
+    alignas(64) uint64_t acc[8];
+    alignas(64) uint8_t secret[secret_bytes];
+    seeded_secret(secret, seed);
+    hash_long(acc, data, len, secret);
+    return digest128_long(acc, len, secret);
+}
+
+hash128_t hash128(std::string_view str, uint64_t seed)
+{
+    return hash128((const uint8_t*)str.data(), str.size(), seed);
+}
+
+// STREAMING
+
+context::context(uint64_t seed) : seed(seed)
+{
+    std::memcpy(acc, init_acc, sizeof(init_acc));
+    seeded_secret(secret, seed);
+}
+
+// accumulates whole stripes, scrambling at each block boundary
+void context::consume_stripes(uint64_t acc[8], size_t& stripes_so_far, const uint8_t* input, size_t num_stripes) const
+{
+    while (num_stripes > 0)
+    {
+        size_t n = stripes_per_block - stripes_so_far;
+        if (num_stripes < n)
+            n = num_stripes;
+
+        accumulate(acc, input, secret + 8*stripes_so_far, n);
+        input += stripe_bytes * n;
+        num_stripes -= n;
+        stripes_so_far += n;
+
+        if (stripes_so_far == stripes_per_block)
+        {
+            scramble(acc, secret + secret_bytes - stripe_bytes);
+            stripes_so_far = 0;
+        }
+    }
+}
+
+void context::update(const uint8_t* data, size_t len)
+{
+    total_len += len;
+
+    if (len <= buffer_bytes - buffered)
+    {
+        std::memcpy(buffer + buffered, data, len);
+        buffered += len;
+        return;
+    }
+
+    // more input follows, so a full buffer can be consumed
+    if (buffered > 0)
+    {
+        size_t take = buffer_bytes - buffered;
+        std::memcpy(buffer + buffered, data, take);
+        data += take;
+        len -= take;
+        consume_stripes(acc, stripes_so_far, buffer, buffer_bytes / stripe_bytes);
+        buffered = 0;
+    }
+
+    // consume straight from the input, keeping at least one byte back and saving the last stripe consumed
+    if (len > buffer_bytes)
+    {
+        size_t num_stripes = (len - 1) / stripe_bytes;
+        consume_stripes(acc, stripes_so_far, data, num_stripes);
+        data += stripe_bytes * num_stripes;
+        len -= stripe_bytes * num_stripes;
+        std::memcpy(buffer + buffer_bytes - stripe_bytes, data - stripe_bytes, stripe_bytes);
+    }
+
+    std::memcpy(buffer, data, len);
+    buffered = len;
+}
+
+// finishes a long input on a copy of the accumulators
+void context::digest_long(uint64_t acc_out[8]) const
+{
+    std::memcpy(acc_out, acc, sizeof(acc));
+
+    alignas(64) uint8_t last_stripe[stripe_bytes];
+    const uint8_t* last;
+    if (buffered >= stripe_bytes)
+    {
+        size_t stripes = stripes_so_far;
+        consume_stripes(acc_out, stripes, buffer, (buffered - 1) / stripe_bytes);
+        last = buffer + buffered - stripe_bytes;
+    }
+    else
+    {
+        // the final 64 bytes start in the previous stripe, which was saved at the end of the buffer
+        size_t catchup = stripe_bytes - buffered;
+        std::memcpy(last_stripe, buffer + buffer_bytes - catchup, catchup);
+        std::memcpy(last_stripe + catchup, buffer, buffered);
+        last = last_stripe;
+    }
+    accumulate_stripe(acc_out, last, secret + secret_bytes - stripe_bytes - 7);
+}
+
+uint64_t context::digest64() const
+{
+    if (total_len <= midsize_max)
+        return hash64(buffer, total_len, seed);
+
+    alignas(64) uint64_t acc_out[8];
+    digest_long(acc_out);
+    return digest64_long(acc_out, total_len, secret);
+}
+
+hash128_t context::digest128() const
+{
+    if (total_len <= midsize_max)
+        return hash128(buffer, total_len, seed);
+
+    alignas(64) uint64_t acc_out[8];
+    digest_long(acc_out);
+    return digest128_long(acc_out, total_len, secret);
+}
+
+#ifdef GV_X86_DISPATCH
+
+// 4 lanes per ymm register, the even/odd lane swap is a shuffle of 32-bit words within each 128-bit half
+__attribute__((target("avx2")))
+void accumulate_avx2(uint64_t acc[8], const uint8_t* input, const uint8_t* secret, size_t num_stripes)
+{
+    __m256i a0 = _mm256_loadu_si256((const __m256i*)acc);
+    __m256i a1 = _mm256_loadu_si256((const __m256i*)(acc + 4));
+
+    for (size_t n = 0; n < num_stripes; ++n)
+    {
+        const uint8_t* stripe = input + stripe_bytes*n;
+        const uint8_t* key = secret + 8*n;
+
+        __m256i d0 = _mm256_loadu_si256((const __m256i*)stripe);
+        __m256i d1 = _mm256_loadu_si256((const __m256i*)(stripe + 32));
+        __m256i k0 = _mm256_xor_si256(d0, _mm256_loadu_si256((const __m256i*)key));
+        __m256i k1 = _mm256_xor_si256(d1, _mm256_loadu_si256((const __m256i*)(key + 32)));
+
+        // (key & 0xffffffff) * (key >> 32)
+        __m256i p0 = _mm256_mul_epu32(k0, _mm256_srli_epi64(k0, 32));
+        __m256i p1 = _mm256_mul_epu32(k1, _mm256_srli_epi64(k1, 32));
+
+        a0 = _mm256_add_epi64(a0, _mm256_add_epi64(p0, _mm256_shuffle_epi32(d0, _MM_SHUFFLE(1, 0, 3, 2))));
+        a1 = _mm256_add_epi64(a1, _mm256_add_epi64(p1, _mm256_shuffle_epi32(d1, _MM_SHUFFLE(1, 0, 3, 2))));
+    }
+
+    _mm256_storeu_si256((__m256i*)acc, a0);
+    _mm256_storeu_si256((__m256i*)(acc + 4), a1);
+}
+
+// AVX2 has no 64 x 64 multiply, the 32-bit prime is multiplied into each half and the halves added
+__attribute__((target("avx2")))
+void scramble_avx2(uint64_t acc[8], const uint8_t* secret)
+{
+    const __m256i prime = _mm256_set1_epi32((int)prime32_1);
+
+    for (int i = 0; i < 2; ++i)
+    {
+        __m256i a = _mm256_loadu_si256((const __m256i*)(acc + 4*i));
+        a = _mm256_xor_si256(a, _mm256_srli_epi64(a, 47));
+        a = _mm256_xor_si256(a, _mm256_loadu_si256((const __m256i*)(secret + 32*i)));
+
+        __m256i lo = _mm256_mul_epu32(a, prime);
+        __m256i hi = _mm256_mul_epu32(_mm256_srli_epi64(a, 32), prime);
+        _mm256_storeu_si256((__m256i*)(acc + 4*i), _mm256_add_epi64(lo, _mm256_slli_epi64(hi, 32)));
+    }
+}
+
+#endif
+
+} // namespace xxh3
+
+} // namespace gv
@@ -0,0 +1,147 @@
+#include <iostream>
+#include "checksum.hpp"
+
+// reference values from xxHash 0.8.2 (XXH3_64bits_withSeed, XXH3_128bits_withSeed) for the first len bytes
+// of the test message, covering each input length class of XXH3
+struct xxh3_vector
+{
+    size_t len;
+    uint64_t seed;
+    uint64_t hash64;
+    const char* hash128;    // high then low half
+};
+
+const xxh3_vector xxh3_vectors[] = {
+    {0, 0, 0x2d06800538d394c2, "99aa06d3014798d86001c324468d497f"},
+    {0, 0x9e3779b97f4a7c15, 0x602b0e2cd6662c8b, "d142977a2cca554b4ca5176998171787"},
+    {3, 0, 0x2b15aa0b3d075427, "9853135c5862576e2b15aa0b3d075427"},
+    {3, 0x9e3779b97f4a7c15, 0x8073415ba996f5f3, "27e045653b340ef78073415ba996f5f3"},
+    {8, 0, 0x44db4d702e7af307, "fb45186b670a4b1895fdbe3342dcacd9"},
+    {8, 0x9e3779b97f4a7c15, 0xc6f554da7f7f5f46, "0099fd8f2986d74b337299e2be413268"},
+    {16, 0, 0x79e8aab409bf708c, "7b7d80840675fe9da60ec7f92a1e499c"},
+    {16, 0x9e3779b97f4a7c15, 0x5f387baae4409a82, "56d51cafe2d435a44cf3f811db8ea04f"},
+    {100, 0, 0x2683dfd767e27cae, "3cf8d44c9d8993f88832c51ce4ad3fed"},
+    {100, 0x9e3779b97f4a7c15, 0x8f118191767a53c4, "153462b70c34a589666b4e3c740b796a"},
+    {200, 0, 0x00ccce1a50c86a89, "f808725b8f7d3f45239b52c22195cbbb"},
+    {200, 0x9e3779b97f4a7c15, 0x16dbb07e76a55c8f, "84b85fd28778945dbb6d92d71e133084"},
+    {1000, 0, 0xeb57edfe005b5ca3, "cbdf5b7da41adca6eb57edfe005b5ca3"},
+    {1000, 0x9e3779b97f4a7c15, 0x36a46c505200276e, "b58c049fcf95f91236a46c505200276e"},
+    {5000, 0, 0x8bc9a3f201747476, "07ce670b8ac9701a8bc9a3f201747476"},
+    {5000, 0x9e3779b97f4a7c15, 0xcd08c55fdae63eaf, "8ac60c9a83467541cd08c55fdae63eaf"},
+};
+
+// CRC32C of the first 100003 bytes of the test message, from a bitwise implementation
+const uint32_t long_crc = 0x114c82fa;
+
+// lengths that end in each part of the hardware paths: the 8-byte loop, the tail bytes, the three
+// 256-byte streams and the three 8192-byte streams with their PCLMUL merges
+const size_t crc_lengths[] = {0, 1, 7, 8, 767, 768, 769, 24575, 24576, 24576 + 768 + 13, 100003};
+
+// every backend that runs on this CPU against the portable slicing-by-8 code
+int check_crc_backends(const std::string& message)
+{
+    int num_wrong = 0;
+    for (size_t len : crc_lengths) {
+        const uint8_t* data = (const uint8_t*)message.data();
+        uint32_t portable = ~gv::crc32c::checksum_portable(0xffffffff, data, len);
+
+        std::vector<uint32_t> got = {gv::crc32c::checksum(data, len)};
+#ifdef GV_X86_DISPATCH
+        if (gv::cpu().sse42)
+            got.push_back(~gv::crc32c::checksum_sse42(0xffffffff, data, len));
+        if (gv::cpu().sse42 && gv::cpu().pclmul)
+            got.push_back(~gv::crc32c::checksum_sse42_clmul(0xffffffff, data, len));
+#endif
+        for (uint32_t c : got)
+            if (c != portable) {
+                std::cout << "CRC32C of " << len << " bytes: " << gv::to_hexcode<uint32_t>(c) << " (should be " << gv::to_hexcode<uint32_t>(portable) << ")" << std::endl;
+                ++num_wrong;
+            }
+    }
+
+    // checksum(a + b) from the checksums of the two parts, and continuing a checksum across them
+    uint32_t whole = gv::crc32c::checksum(message);
+    for (size_t split : {(size_t)0, (size_t)1, (size_t)1000, (size_t)50000, message.size()}) {
+        std::string_view a = std::string_view(message).substr(0, split), b = std::string_view(message).substr(split);
+        if (gv::crc32c::combine(gv::crc32c::checksum(a), gv::crc32c::checksum(b), b.size()) != whole
+            || gv::crc32c::checksum(b, gv::crc32c::checksum(a)) != whole)
+            ++num_wrong;
+    }
+
+    // uneven lengths, so that the interleaved strings stop at the shortest and finish one at a time
+    std::vector<std::string> strs;
+    for (size_t len : {5000, 4093, 17, 0, 9000, 777, 64, 65, 3})
+        strs.push_back(message.substr(len % 101, len));
+    std::vector<uint32_t> batch = gv::crc32c::checksum_batch(strs);
+    for (size_t i = 0; i < strs.size(); ++i)
+        if (batch[i] != gv::crc32c::checksum(strs[i]))
+            ++num_wrong;
+
+    return num_wrong;
+}
+
+// streaming XXH3 in chunks of several sizes against the one-shot hashes
+int check_xxh3_context(const std::string& message)
+{
+    int num_wrong = 0;
+    for (uint64_t seed : {(uint64_t)0, (uint64_t)0x9e3779b97f4a7c15})
+        for (size_t len : {0, 100, 240, 241, 1024, 5000})
+            for (size_t chunk : {1, 7, 64, 255, 1000}) {
+                gv::xxh3::context ctx(seed);
+                for (size_t offset = 0; offset < len; offset += chunk)
+                    ctx.update((const uint8_t*)message.data() + offset, std::min(chunk, len - offset));
+
+                gv::xxh3::hash128_t h128 = gv::xxh3::hash128((const uint8_t*)message.data(), len, seed);
+                gv::xxh3::hash128_t c128 = ctx.digest128();
+                if (ctx.digest64() != gv::xxh3::hash64((const uint8_t*)message.data(), len, seed) || c128.high != h128.high || c128.low != h128.low) {
+                    std::cout << "XXH3 context, " << len << " bytes in chunks of " << chunk << ", seed " << seed << ": differs from the one-shot hash" << std::endl;
+                    ++num_wrong;
+                }
+            }
+    return num_wrong;
+}
+
+int main(int argc, char* argv[]) {
+    // check value from the CRC catalogue
+    uint32_t crc = gv::crc32c::checksum("123456789");
+    std::cout << "CRC32C(123456789) = " << gv::to_hexcode<uint32_t>(crc) << " (should be e3069283)" << std::endl;
+
+    std::string message;
+    for (int i = 0; i < 100003; ++i)
+        message.push_back((char)(i * 37));
+
+    uint32_t crc_long = gv::crc32c::checksum(message);
+    int num_crc_wrong = check_crc_backends(message) + (crc_long != long_crc);
+    std::cout << "CRC32C backends, combine and batch: " << num_crc_wrong << " wrong" << std::endl;
+
+    int num_wrong = 0;
+    for (const xxh3_vector& v : xxh3_vectors) {
+        uint64_t h64 = gv::xxh3::hash64((const uint8_t*)message.data(), v.len, v.seed);
+        gv::xxh3::hash128_t h128 = gv::xxh3::hash128((const uint8_t*)message.data(), v.len, v.seed);
+        std::string hex128 = gv::to_hexcode<uint64_t>(h128.high) + gv::to_hexcode<uint64_t>(h128.low);
+
+        if (h64 != v.hash64 || hex128 != v.hash128) {
+            std::cout << "XXH3 of " << v.len << " bytes, seed " << v.seed << ": " << gv::to_hexcode<uint64_t>(h64) << " " << hex128
+                      << " (should be " << gv::to_hexcode<uint64_t>(v.hash64) << " " << v.hash128 << ")" << std::endl;
+            ++num_wrong;
+        }
+    }
+    std::cout << "XXH3 reference vectors: " << num_wrong << " wrong" << std::endl;
+
+    int num_context_wrong = check_xxh3_context(message);
+    std::cout << "XXH3 streaming: " << num_context_wrong << " wrong" << std::endl;
+
+    if (argc > 1) {
+
+        std::string input(argv[1]);
+
+        gv::xxh3::hash128_t h128 = gv::xxh3::hash128(input);
+
+        std::cout << input << " >>>> CRC32C >>>> " << gv::to_hexcode<uint32_t>(gv::crc32c::checksum(input)) << std::endl;
+        std::cout << input << " >>>> XXH3-64 >>>> " << gv::to_hexcode<uint64_t>(gv::xxh3::hash64(input)) << std::endl;
+        std::cout << input << " >>>> XXH3-128 >>>> " << gv::to_hexcode<uint64_t>(h128.high) << gv::to_hexcode<uint64_t>(h128.low) << std::endl;
+
+    }
+
+    return (crc == 0xe3069283 && num_crc_wrong == 0 && num_wrong == 0 && num_context_wrong == 0) ? 0 : 1;
+}
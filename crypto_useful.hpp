@@ -13,8 +13,20 @@ William Denny
 #include <string>
 #include <bitset>
 #include <array>
+#include <string_view>
+#include <utility>
+#include <cstring>
+#include <stdexcept>
 #include <assert.h>
 
+// x86 backends are selected at runtime via cpuid
+// define GV_NO_CPU_DISPATCH to build only the portable code paths
+#if !defined(GV_NO_CPU_DISPATCH) && (defined(__x86_64__) || defined(__i386__)) && (defined(__GNUC__) || defined(__clang__))
+#define GV_X86_DISPATCH 1
+#include <cpuid.h>
+#include <immintrin.h>
+#endif
+
 namespace gv
 {
 
@@ -23,7 +35,7 @@ namespace gv
 // **************************************************************************************************************
 
 template <typename T>
-T modulo(T x, const uint32_t& n)
+constexpr T modulo(T x, const uint32_t& n)
 {
     while (x < 0)
         x += n;
@@ -35,22 +47,23 @@ T modulo(T x, const uint32_t& n)
 // **************************************************************************************************************
 
 // circular left shift
+// the second shift is taken modulo the word size as well, so that a shift by 0 is not undefined
 template <typename T>
-T circ_left_shift(const T& word,  const uint32_t& n)
+constexpr T circ_left_shift(const T& word,  const uint32_t& n)
 {
-    return (word << modulo(n,sizeof(T)*8)) | (word >> (sizeof(T)*8 - modulo(n,sizeof(T)*8)));
+    return (word << modulo(n,sizeof(T)*8)) | (word >> modulo(sizeof(T)*8 - modulo(n,sizeof(T)*8), sizeof(T)*8));
 }
 
 // circular right shift
 template <typename T>
-T circ_right_shift(const T& word, const uint32_t& n)
+constexpr T circ_right_shift(const T& word, const uint32_t& n)
 {
-    return (word >> modulo(n,sizeof(T)*8)) | (word << (sizeof(T)*8 - modulo(n,sizeof(T)*8)));
+    return (word >> modulo(n,sizeof(T)*8)) | (word << modulo(sizeof(T)*8 - modulo(n,sizeof(T)*8), sizeof(T)*8));
 }
 
 // set/clear bit
 template <typename T, bool big_endian>
-void set_bit(T& word, const uint32_t& index, const bool& val)
+constexpr void set_bit(T& word, const uint32_t& index, const bool& val)
 {
     if (big_endian == false)
     {
@@ -72,7 +85,7 @@ void set_bit(T& word, const uint32_t& index, const bool& val)
 
 // check bit
 template <typename T, bool big_endian>
-bool check_bit(T& word, const uint32_t& index)
+constexpr bool check_bit(T& word, const uint32_t& index)
 {
     if (big_endian == false)
     {
@@ -86,7 +99,7 @@ bool check_bit(T& word, const uint32_t& index)
 
 // toggle bit
 template <typename T, bool big_endian>
-void toggle_bit(T& word, const uint32_t& index)
+constexpr void toggle_bit(T& word, const uint32_t& index)
 {
     if (big_endian == false)
     {
@@ -100,7 +113,7 @@ void toggle_bit(T& word, const uint32_t& index)
 
 // reverses bits in a datatype of any number of bytes
 template <typename T>
-T reverse_b(T x)
+constexpr T reverse_b(T x)
 {
     T y = 0;
     for (int i = 0; i < sizeof(T)*8; ++i)
@@ -115,11 +128,11 @@ T reverse_b(T x)
 // keeps byte order the same
 // reverses bit order within each byte
 template <typename T>
-T reverse_binB(const T& x)
+constexpr T reverse_binB(const T& x)
 {
     T y = 0;
     T k = (T)0xff << (sizeof(T) - 1)*8;
-    T b;
+    T b = 0;
     for (int i = 0; i < sizeof(T); ++i)
     {
         b = k & x;
@@ -134,7 +147,7 @@ T reverse_binB(const T& x)
 // reverses order of bytes
 // keeps bit order the same within each byte
 template <typename T>
-T reverse_B(T x)
+constexpr T reverse_B(T x)
 {
     T y = 0;
     for (int i = 0; i < sizeof(T); ++i)
@@ -206,6 +219,385 @@ T from_hexcode(const std::string& hexcode)
     return word;
 }
 
+// returns string of raw bytes as hexcode string, e.g. for keys and ciphertexts
+std::string bytes_to_hexcode(const std::string& bytes)
+{
+    std::string hexcode;
+    for (size_t i = 0; i < bytes.size(); ++i)
+        hexcode += to_hexcode<uint8_t>((uint8_t)bytes[i]);
+    return hexcode;
+}
+
+// returns a digest/array of bytes as hexcode string
+template <size_t N>
+std::string bytes_to_hexcode(const std::array<uint8_t, N>& bytes)
+{
+    return bytes_to_hexcode(std::string((const char*)bytes.data(), N));
+}
+
+// returns the first sizeof(T) bytes of a digest as a big-endian integer
+// usable at compile time, e.g. as a case label or template argument
+template <typename T, size_t N>
+constexpr T digest_word(const std::array<uint8_t, N>& digest)
+{
+    static_assert(sizeof(T) <= N, "digest is shorter than the requested word");
+
+    T word = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        word = (T)(word << 8) | digest[i];
+    return word;
+}
+
+// converts a hexcode string with an even number of digits into a string of raw bytes
+std::string hexcode_to_bytes(const std::string& hexcode)
+{
+    assert(hexcode.size() % 2 == 0);
+
+    std::string bytes;
+    for (size_t i = 0; i < hexcode.size() / 2; ++i)
+        bytes += (char)from_hexcode<uint8_t>(hexcode.substr(2*i, 2));
+    return bytes;
+}
+
+// **************************************************************************************************************
+//   HASHING HELPERS
+// **************************************************************************************************************
+
+// loads a big-endian word
+template <typename T>
+constexpr T load_be(const uint8_t* p)
+{
+    T word = 0;
+    for (size_t i = 0; i < sizeof(T); ++i)
+        word = (T)(word << 8) | p[i];
+    return word;
+}
+
+// loads a little-endian word
+// written as a fold over the bytes rather than a loop, which compilers merge into a single unaligned move
+template <typename T, size_t... I>
+constexpr T load_le(const uint8_t* p, std::index_sequence<I...>)
+{
+    return (((T)p[I] << (8*I)) | ...);
+}
+
+template <typename T>
+constexpr T load_le(const uint8_t* p)
+{
+    return load_le<T>(p, std::make_index_sequence<sizeof(T)>());
+}
+
+// stores a little-endian word, a single move as for load_le
+template <typename T, size_t... I>
+constexpr void store_le(uint8_t* p, T word, std::index_sequence<I...>)
+{
+    ((p[I] = (uint8_t)(word >> (8*I))), ...);
+}
+
+template <typename T>
+constexpr void store_le(uint8_t* p, T word)
+{
+    store_le<T>(p, word, std::make_index_sequence<sizeof(T)>());
+}
+
+// pads the final partial block of a message for SHA-1/SHA-2
+// appends a binary 1, zeros, then the length of the whole message in bits as a big-endian integer of len_bytes bytes
+// returns the final 1 or 2 blocks
+std::vector<uint8_t> md_pad(const uint8_t* tail, size_t tail_len, uint64_t msg_len, uint32_t block_bytes, uint32_t len_bytes)
+{
+    assert(tail_len < block_bytes);
+
+    // the 1 bit and the length need len_bytes + 1 bytes after the tail
+    size_t num_blocks = (tail_len + 1 + len_bytes <= block_bytes) ? 1 : 2;
+    std::vector<uint8_t> blocks(num_blocks * block_bytes, 0);
+
+    std::memcpy(blocks.data(), tail, tail_len);
+    blocks[tail_len] = 0b10000000;
+
+    // the length is < 2^64 bits so any higher bytes of the length field stay zero
+    uint64_t msg_bits = msg_len * 8;
+    for (int i = 0; i < 8; ++i)
+        blocks[blocks.size() - 1 - i] = (uint8_t)(msg_bits >> (8*i));
+
+    return blocks;
+}
+
+// applies the SHA-3 suffix 01 and the padding rule 10*1 to a zeroed final block holding tail_len message bytes
+constexpr void sha3_pad_block(uint8_t* block, uint64_t tail_len, uint32_t block_bytes)
+{
+    block[tail_len] ^= reverse_b<uint8_t>(0b01100000);
+    block[block_bytes - 1] ^= reverse_b<uint8_t>(0b00000001);
+}
+
+// pads the final partial block of a message for SHA-3
+// unlike md_pad the message length is not encoded, so the padding always fits in one block
+std::vector<uint8_t> sha3_pad(const uint8_t* tail, size_t tail_len, uint32_t block_bytes)
+{
+    assert(tail_len < block_bytes);
+
+    std::vector<uint8_t> block(block_bytes, 0);
+    std::memcpy(block.data(), tail, tail_len);
+    sha3_pad_block(block.data(), tail_len, block_bytes);
+    return block;
+}
+
+// schedules the blocks of up to num_lanes messages for a multi-buffer kernel, which compresses one block per lane
+// full blocks are read in place, the padded tail of each message is kept separately
+// lanes past the end of their message are given a zero block and left out of the active mask
+template <uint32_t num_lanes, uint32_t block_bytes>
+class lane_schedule
+{
+
+public:
+    // pad(tail, tail_len, msg_len) returns the padded final block(s) of a message
+    template <typename Pad>
+    lane_schedule(const std::string* strs, uint32_t num_strs, Pad pad)
+    {
+        assert(num_strs <= num_lanes);
+
+        for (uint32_t l = 0; l < num_strs; ++l)
+        {
+            data[l] = (const uint8_t*)strs[l].data();
+            full_blocks[l] = strs[l].size() / block_bytes;
+            tails[l] = pad(data[l] + block_bytes*full_blocks[l], strs[l].size() % block_bytes, strs[l].size());
+            total_blocks[l] = full_blocks[l] + tails[l].size() / block_bytes;
+            if (total_blocks[l] > max_blocks)
+                max_blocks = total_blocks[l];
+        }
+    }
+
+    size_t num_blocks() const { return max_blocks; }
+
+    // sets blocks to block b of each lane and returns the mask of lanes that have a block b
+    uint32_t blocks(size_t b, const uint8_t* blocks[num_lanes]) const
+    {
+        uint32_t active = 0;
+        for (uint32_t l = 0; l < num_lanes; ++l)
+        {
+            if (b < full_blocks[l])
+                blocks[l] = data[l] + block_bytes*b;
+            else if (b < total_blocks[l])
+                blocks[l] = tails[l].data() + block_bytes*(b - full_blocks[l]);
+            else
+                blocks[l] = zero_block;
+
+            if (b < total_blocks[l])
+                active |= 1u << l;
+        }
+        return active;
+    }
+
+private:
+    std::vector<uint8_t> tails[num_lanes];
+    const uint8_t* data[num_lanes] = {};
+    size_t full_blocks[num_lanes] = {};
+    size_t total_blocks[num_lanes] = {};
+    size_t max_blocks = 0;
+    alignas(32) uint8_t zero_block[block_bytes] = {};
+};
+
+// **************************************************************************************************************
+//   MIDSTATE SERIALISATION
+// **************************************************************************************************************
+
+// the state of a streaming hash context can be saved and resumed later, e.g. to carry on hashing an
+// append-only file from a checkpoint instead of from byte 0
+//
+// format (version 1), all integers little-endian:
+//      4 bytes     magic "GVMS"
+//      1 byte      format version
+//      1 byte      algorithm id
+//      8 bytes     number of message bytes hashed so far
+//      n words     hash state words
+//      k bytes     buffered partial block, k = message bytes % block size
+
+const uint8_t midstate_version = 1;
+
+const size_t midstate_header_bytes = 14;
+
+enum class midstate_algorithm : uint8_t
+{
+    sha1 = 1,
+    sha3_256 = 2,
+    sha256 = 3,
+    sha224 = 4,
+    sha512 = 5,
+    sha384 = 6
+};
+
+// appends a word as little-endian bytes
+template <typename T>
+void append_le(std::string& out, T word)
+{
+    for (size_t i = 0; i < sizeof(T); ++i)
+        out.push_back((char)(uint8_t)(word >> (8*i)));
+}
+
+template <typename T, size_t N>
+std::string export_midstate(midstate_algorithm algorithm, uint64_t msg_len, const std::array<T, N>& state,
+                            const uint8_t* buffer, uint32_t block_bytes)
+{
+    std::string out = "GVMS";
+    out.push_back((char)midstate_version);
+    out.push_back((char)algorithm);
+    append_le<uint64_t>(out, msg_len);
+    for (size_t i = 0; i < N; ++i)
+        append_le<T>(out, state[i]);
+    out.append((const char*)buffer, msg_len % block_bytes);
+    return out;
+}
+
+// reads a midstate written by export_midstate, throws std::invalid_argument if it is malformed
+// or was written for a different algorithm
+template <typename T, size_t N>
+void import_midstate(const std::string& data, midstate_algorithm algorithm, uint64_t& msg_len, std::array<T, N>& state,
+                     uint8_t* buffer, uint32_t block_bytes)
+{
+    const uint8_t* p = (const uint8_t*)data.data();
+
+    if (data.size() < midstate_header_bytes || data.compare(0, 4, "GVMS") != 0)
+        throw std::invalid_argument("midstate: not a hash midstate");
+    if (p[4] != midstate_version)
+        throw std::invalid_argument("midstate: unsupported format version " + std::to_string(p[4]));
+    if (p[5] != (uint8_t)algorithm)
+        throw std::invalid_argument("midstate: written by a different hash algorithm");
+
+    msg_len = load_le<uint64_t>(p + 6);
+    size_t buffered = msg_len % block_bytes;
+    if (data.size() != midstate_header_bytes + N*sizeof(T) + buffered)
+        throw std::invalid_argument("midstate: wrong size for the recorded message length");
+
+    p += midstate_header_bytes;
+    for (size_t i = 0; i < N; ++i)
+        state[i] = load_le<T>(p + sizeof(T)*i);
+    std::memcpy(buffer, p + N*sizeof(T), buffered);
+}
+
+// **************************************************************************************************************
+//   CPU FEATURES
+// **************************************************************************************************************
+
+// instruction set extensions used by the accelerated backends
+// all flags are false on non-x86 targets or when GV_NO_CPU_DISPATCH is defined
+struct cpu_features
+{
+    bool sse2   = false;
+    bool ssse3  = false;
+    bool sse41  = false;
+    bool sse42  = false;
+    bool aesni  = false;
+    bool pclmul = false;
+    bool avx2   = false;
+    bool sha    = false;
+};
+
+// queries cpuid for the supported extensions
+// AVX2 also requires the OS to save the ymm registers (checked with xgetbv)
+cpu_features detect_cpu_features()
+{
+    cpu_features features;
+
+#ifdef GV_X86_DISPATCH
+    unsigned int eax, ebx, ecx, edx;
+
+    if (__get_cpuid(1, &eax, &ebx, &ecx, &edx))
+    {
+        features.sse2   = (edx >> 26) & 1;
+        features.ssse3  = (ecx >> 9)  & 1;
+        features.sse41  = (ecx >> 19) & 1;
+        features.sse42  = (ecx >> 20) & 1;
+        features.aesni  = (ecx >> 25) & 1;
+        features.pclmul = (ecx >> 1)  & 1;
+
+        bool os_ymm = false;
+        if (((ecx >> 27) & 1) && ((ecx >> 28) & 1))
+        {
+            // xgetbv with ecx = 0 reads XCR0, bits 1 and 2 are the xmm and ymm state
+            unsigned int xcr0_lo, xcr0_hi;
+            __asm__ volatile ("xgetbv" : "=a"(xcr0_lo), "=d"(xcr0_hi) : "c"(0));
+            os_ymm = (xcr0_lo & 0x6) == 0x6;
+        }
+
+        if (__get_cpuid_count(7, 0, &eax, &ebx, &ecx, &edx))
+        {
+            features.avx2 = os_ymm && ((ebx >> 5) & 1);
+            features.sha  = (ebx >> 29) & 1;
+        }
+    }
+#endif
+
+    return features;
+}
+
+// cpu features of the host, detected once and shared by all backends
+const cpu_features& cpu()
+{
+    static const cpu_features features = detect_cpu_features();
+    return features;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// **************************************************************************************************************
+//   SIMD HELPERS (multi-buffer hashing)
+// **************************************************************************************************************
+
+// transposes 8 rows of 8 32-bit words, so that row i of the output holds word i of every input row
+__attribute__((target("avx2")))
+void transpose_8x8_epi32(__m256i r[8])
+{
+    __m256i t[8], u[8];
+    for (int i = 0; i < 4; ++i)
+    {
+        t[2*i]     = _mm256_unpacklo_epi32(r[2*i], r[2*i + 1]);
+        t[2*i + 1] = _mm256_unpackhi_epi32(r[2*i], r[2*i + 1]);
+    }
+    for (int i = 0; i < 2; ++i)
+    {
+        u[4*i]     = _mm256_unpacklo_epi64(t[4*i],     t[4*i + 2]);
+        u[4*i + 1] = _mm256_unpackhi_epi64(t[4*i],     t[4*i + 2]);
+        u[4*i + 2] = _mm256_unpacklo_epi64(t[4*i + 1], t[4*i + 3]);
+        u[4*i + 3] = _mm256_unpackhi_epi64(t[4*i + 1], t[4*i + 3]);
+    }
+    for (int i = 0; i < 4; ++i)
+    {
+        r[i]     = _mm256_permute2x128_si256(u[i], u[i + 4], 0x20);
+        r[i + 4] = _mm256_permute2x128_si256(u[i], u[i + 4], 0x31);
+    }
+}
+
+// mask of all ones in each 32-bit lane whose bit is set in active
+__attribute__((target("avx2")))
+__m256i lane_mask_epi32(uint32_t active)
+{
+    const __m256i bits = _mm256_setr_epi32(1, 2, 4, 8, 16, 32, 64, 128);
+    return _mm256_cmpeq_epi32(_mm256_and_si256(_mm256_set1_epi32(active), bits), bits);
+}
+
+// transposes 4 rows of 4 64-bit words
+__attribute__((target("avx2")))
+void transpose_4x4_epi64(__m256i r[4])
+{
+    __m256i t0 = _mm256_unpacklo_epi64(r[0], r[1]);
+    __m256i t1 = _mm256_unpackhi_epi64(r[0], r[1]);
+    __m256i t2 = _mm256_unpacklo_epi64(r[2], r[3]);
+    __m256i t3 = _mm256_unpackhi_epi64(r[2], r[3]);
+    r[0] = _mm256_permute2x128_si256(t0, t2, 0x20);
+    r[1] = _mm256_permute2x128_si256(t1, t3, 0x20);
+    r[2] = _mm256_permute2x128_si256(t0, t2, 0x31);
+    r[3] = _mm256_permute2x128_si256(t1, t3, 0x31);
+}
+
+// mask of all ones in each 64-bit lane whose bit is set in active
+__attribute__((target("avx2")))
+__m256i lane_mask_epi64(uint32_t active)
+{
+    const __m256i bits = _mm256_setr_epi64x(1, 2, 4, 8);
+    return _mm256_cmpeq_epi64(_mm256_and_si256(_mm256_set1_epi64x(active), bits), bits);
+}
+
+#endif
+
 // **************************************************************************************************************
 //   PRINTING FUNCTIONS
 // **************************************************************************************************************
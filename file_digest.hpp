@@ -0,0 +1,802 @@
+/*
+File digests with a persistent cache
+
+William Denny
+
+    - digest_file hashes a file with SHA-1 or SHA3-256 through the streaming contexts
+
+    - digest_cache remembers (device, inode, size, mtime, algorithm) -> digest in a table on disk, so
+      rehashing a tree in which nothing has changed costs one stat per file instead of reading it
+
+    - Lookups are lock-free. The table is an open-addressed hash table in an mmap-ed file that is never
+      modified in place, and readers only count themselves into the current mapping, which is unmapped
+      once it has been replaced and its last reader has left
+
+    - New digests are batched in memory and flushed by a background thread. A flush locks the table
+      (flock), merges in what other writers have saved, writes a complete new table to a temporary file,
+      fsyncs it and renames it over the old one, so a crash leaves either the old or the new table. Every
+      record carries a CRC32C and damaged records are treated as missing
+
+    - Records of files that no lookup has used for 30 days are dropped when the table is rewritten
+
+    - POSIX only (stat, mmap, rename, flock)
+
+*/
+
+#pragma once
+
+#if !defined(__unix__) && !defined(__APPLE__)
+#error "file_digest.hpp needs a POSIX system (stat, mmap, rename, flock)"
+#endif
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <memory>
+#include <algorithm>
+#include <atomic>
+#include <mutex>
+#include <condition_variable>
+#include <thread>
+#include <chrono>
+#include <unordered_map>
+#include <system_error>
+#include <cerrno>
+#include <cstring>
+
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <sys/mman.h>
+#include <sys/file.h>
+
+#include "crypto_useful.hpp"
+#include "checksum.hpp"
+#include "sha1.hpp"
+#include "sha3_256.hpp"
+
+namespace gv
+{
+
+// **************************************************************************************************************
+// FILE DIGESTS
+// **************************************************************************************************************
+
+enum class file_algorithm : uint8_t
+{
+    sha1 = 1,
+    sha3_256 = 2
+};
+
+// identifies one version of a file as far as stat can tell
+struct file_key
+{
+    uint64_t dev;
+    uint64_t ino;
+    uint64_t size;
+    int64_t mtime_ns;
+    file_algorithm algorithm;
+};
+
+file_key make_file_key(const struct stat& st, file_algorithm algorithm);
+
+// raw digest of the rest of the file open as fd, path is only used in error messages
+std::string hash_fd(int fd, file_algorithm algorithm, const std::string& path);
+
+// digest of the file contents as a hexcode, throws std::system_error if the file cannot be read
+std::string digest_file(const std::string& path, file_algorithm algorithm);
+
+file_key make_file_key(const struct stat& st, file_algorithm algorithm)
+{
+#ifdef __APPLE__
+    int64_t mtime_ns = (int64_t)st.st_mtimespec.tv_sec * 1000000000 + st.st_mtimespec.tv_nsec;
+#else
+    int64_t mtime_ns = (int64_t)st.st_mtim.tv_sec * 1000000000 + st.st_mtim.tv_nsec;
+#endif
+    return {(uint64_t)st.st_dev, (uint64_t)st.st_ino, (uint64_t)st.st_size, mtime_ns, algorithm};
+}
+
+std::string hash_fd(int fd, file_algorithm algorithm, const std::string& path)
+{
+    sha1::context sha1_ctx;
+    sha3_256::context sha3_ctx;
+
+    std::vector<uint8_t> chunk(1 << 18);
+    for (;;)
+    {
+        ssize_t n = read(fd, chunk.data(), chunk.size());
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            throw std::system_error(errno, std::generic_category(), "digest_file: cannot read " + path);
+        if (n == 0)
+            break;
+
+        if (algorithm == file_algorithm::sha1)
+            sha1_ctx.update(chunk.data(), n);
+        else
+            sha3_ctx.update(chunk.data(), n);
+    }
+
+    if (algorithm == file_algorithm::sha1)
+    {
+        sha1_digest d = sha1_ctx.finalize();
+        return std::string(d.begin(), d.end());
+    }
+    sha3_256::digest_t d = sha3_ctx.finalize();
+    return std::string(d.begin(), d.end());
+}
+
+std::string digest_file(const std::string& path, file_algorithm algorithm)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "digest_file: cannot open " + path);
+
+    std::string digest;
+    try
+    {
+        digest = hash_fd(fd, algorithm, path);
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    return bytes_to_hexcode(digest);
+}
+
+// **************************************************************************************************************
+// DIGEST CACHE
+// **************************************************************************************************************
+
+// table file format, all integers little-endian
+//   header (32 bytes): "GVDC", version (1 byte), 3 zero bytes, capacity (u64, a power of 2), number of
+//                      records (u64), 4 zero bytes, CRC32C of the preceding 28 bytes (u32)
+//   capacity slots (72 bytes each): dev, ino, size, mtime_ns (u64 each), algorithm (1 byte, 0 = empty slot),
+//                      digest length (1 byte), day the record was last used (u16, days since 1970-01-01),
+//                      digest (32 bytes, zero padded), CRC32C of the preceding 68 bytes (u32)
+// a record lives in the first free slot at or after xxh3 of its first 33 bytes (the key) mod capacity
+
+const uint8_t digest_cache_version = 2;
+const size_t digest_cache_header_bytes = 32;
+const size_t digest_cache_record_bytes = 72;
+const size_t digest_cache_key_bytes = 33;
+
+// files modified less than this long before they were hashed are not cached, since a second write within
+// the same timestamp tick would leave size and mtime unchanged (the "racy clean" case)
+const int64_t digest_cache_racy_ns = 2000000000;
+
+// records that no lookup has used for this many days are dropped when the table is rewritten, which is how
+// deleted files and files replaced by a new inode (an editor saving through a rename) leave the table
+const int64_t digest_cache_max_age_days = 30;
+
+class digest_cache
+{
+
+public:
+    // loads the table at path if there is a valid one, otherwise starts empty and creates it on the first flush
+    // once batch_size new digests are pending they are flushed by a background thread
+    explicit digest_cache(std::string path, size_t batch_size = 4096);
+
+    // flushes pending digests, errors are ignored here so call flush first to see them
+    ~digest_cache();
+
+    digest_cache(const digest_cache&) = delete;
+    digest_cache& operator=(const digest_cache&) = delete;
+
+    // same result as gv::digest_file, but the file is not read if a digest is cached for its current
+    // device, inode, size and mtime
+    std::string digest_file(const std::string& path, file_algorithm algorithm);
+
+    // raw digest cached for key, lock-free unless key is only in the pending batch
+    bool lookup(const file_key& key, std::string& digest) const;
+
+    // records a raw digest, it is written to disk by the next flush
+    void insert(const file_key& key, const std::string& digest);
+
+    // merges the table on disk (which other caches may have rewritten) with all pending digests, writes the
+    // result and switches lookups over to it
+    // throws std::system_error on I/O errors, the pending digests are kept for the next attempt
+    void flush();
+
+    // number of records in the table last loaded or written (excluding pending digests)
+    uint64_t size() const;
+
+    uint64_t num_hits() const { return hits.load(std::memory_order_relaxed); }
+    uint64_t num_misses() const { return misses.load(std::memory_order_relaxed); }
+
+private:
+    // a read-only mapping of one version of the table
+    // table objects are reused rather than deleted, so a lookup may still count itself into one that has
+    // just been retired, it then sees that current has moved on and tries again
+    struct table
+    {
+        const uint8_t* data = nullptr;
+        size_t bytes = 0;
+        uint64_t capacity = 0;
+        uint64_t count = 0;
+
+        // lookups that may be reading data
+        std::atomic<uint32_t> readers{0};
+        std::atomic<bool> retired{false};
+
+        // one bit per slot, set by lookups that hit it so that the flush refreshes the record's last-used day
+        std::unique_ptr<std::atomic<uint64_t>[]> used;
+
+        ~table() { unmap(); }
+
+        void map(const uint8_t* data, size_t bytes, uint64_t capacity, uint64_t count);
+        void unmap();
+
+        const uint8_t* slot(uint64_t i) const { return data + digest_cache_header_bytes + i*digest_cache_record_bytes; }
+    };
+
+    // counts a lookup into the current table, the last lookup to leave a retired table releases it
+    struct reader_guard
+    {
+        const digest_cache& cache;
+        table* t;
+        reader_guard(const digest_cache& cache);
+        ~reader_guard();
+    };
+
+    // an exclusive flock on path + ".lock", held while a flush reads, merges and replaces the table on disk,
+    // so caches on the same path in this and other processes do not lose each other's digests
+    struct writer_lock
+    {
+        int fd;
+        writer_lock(const std::string& path);
+        ~writer_lock() { close(fd); }
+    };
+
+    std::string path;
+    size_t batch_size;
+
+    std::atomic<table*> current;
+
+    // every table object, those in use are current, retired (waiting for their readers) or spare
+    // lookups release retired tables too, so these are guarded by flush_mutex rather than owned by flush
+    std::vector<std::unique_ptr<table>> tables;
+    mutable std::vector<table*> retired;
+    mutable std::vector<table*> spare;
+
+    // pending digests by encoded key, the mutex is not taken by lookups that hit the table
+    // it also guards the flush requests to the background thread
+    mutable std::mutex pending_mutex;
+    std::unordered_map<std::string, std::string> pending;
+    std::condition_variable wake;
+    bool flush_requested = false;
+    bool stopping = false;
+
+    // one flush at a time, it also guards the table objects
+    mutable std::mutex flush_mutex;
+
+    mutable std::atomic<uint64_t> hits{0};
+    mutable std::atomic<uint64_t> misses{0};
+
+    std::thread flusher;
+
+    static std::string encode_key(const file_key& key);
+    static bool valid_record(const uint8_t* record);
+    static void load(const std::string& path, table& t);
+    static void remove_temp_files(const std::string& path);
+
+    table* spare_table();
+    void write_table(const std::unordered_map<std::string, std::string>& batch);
+    void reclaim() const;
+    void run();
+};
+
+void digest_cache::table::map(const uint8_t* data, size_t bytes, uint64_t capacity, uint64_t count)
+{
+    this->data = data;
+    this->bytes = bytes;
+    this->capacity = capacity;
+    this->count = count;
+    used.reset(new std::atomic<uint64_t>[(capacity + 63) / 64]());
+}
+
+void digest_cache::table::unmap()
+{
+    if (data != nullptr)
+        munmap((void*)data, bytes);
+    data = nullptr;
+    bytes = 0;
+    capacity = 0;
+    count = 0;
+    used.reset();
+}
+
+// if current was replaced between loading it and counting in, the flush may already have released that
+// table, so count into the new one instead
+digest_cache::reader_guard::reader_guard(const digest_cache& cache) : cache(cache)
+{
+    for (;;)
+    {
+        t = cache.current.load();
+        t->readers.fetch_add(1);
+        if (cache.current.load() == t)
+            return;
+        t->readers.fetch_sub(1);
+    }
+}
+
+digest_cache::reader_guard::~reader_guard()
+{
+    // a flush that is running will reclaim the table itself when it is done
+    if (t->readers.fetch_sub(1) == 1 && t->retired.load())
+    {
+        std::unique_lock<std::mutex> lock(cache.flush_mutex, std::try_to_lock);
+        if (lock.owns_lock())
+            cache.reclaim();
+    }
+}
+
+digest_cache::writer_lock::writer_lock(const std::string& path)
+{
+    std::string lock_path = path + ".lock";
+    fd = open(lock_path.c_str(), O_RDWR | O_CREAT | O_CLOEXEC, 0644);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "digest_cache: cannot open " + lock_path);
+
+    while (flock(fd, LOCK_EX) != 0)
+    {
+        if (errno == EINTR)
+            continue;
+        int err = errno;
+        close(fd);
+        throw std::system_error(err, std::generic_category(), "digest_cache: cannot lock " + lock_path);
+    }
+}
+
+digest_cache::digest_cache(std::string path, size_t batch_size)
+    : path(std::move(path)), batch_size(batch_size == 0 ? 1 : batch_size)
+{
+    table* t = spare_table();
+    load(this->path, *t);
+    current.store(t);
+
+    flusher = std::thread(&digest_cache::run, this);
+}
+
+digest_cache::~digest_cache()
+{
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        stopping = true;
+    }
+    wake.notify_one();
+    flusher.join();
+
+    try
+    {
+        flush();
+    }
+    catch (...)
+    {
+    }
+}
+
+std::string digest_cache::encode_key(const file_key& key)
+{
+    std::string out;
+    append_le<uint64_t>(out, key.dev);
+    append_le<uint64_t>(out, key.ino);
+    append_le<uint64_t>(out, key.size);
+    append_le<uint64_t>(out, (uint64_t)key.mtime_ns);
+    out.push_back((char)key.algorithm);
+    return out;
+}
+
+bool digest_cache::valid_record(const uint8_t* record)
+{
+    uint8_t len = record[digest_cache_key_bytes];
+    return len <= 32 && crc32c::checksum(record, digest_cache_record_bytes - 4) == load_le<uint32_t>(record + digest_cache_record_bytes - 4);
+}
+
+// a missing, truncated or damaged table is treated as empty, it is replaced by the next flush
+void digest_cache::load(const std::string& path, table& t)
+{
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        return;
+
+    struct stat st;
+    if (fstat(fd, &st) != 0 || (size_t)st.st_size < digest_cache_header_bytes)
+    {
+        close(fd);
+        return;
+    }
+
+    void* data = mmap(nullptr, st.st_size, PROT_READ, MAP_SHARED, fd, 0);
+    close(fd);
+    if (data == MAP_FAILED)
+        return;
+
+    const uint8_t* header = (const uint8_t*)data;
+    uint64_t capacity = load_le<uint64_t>(header + 8);
+    bool valid = std::memcmp(header, "GVDC", 4) == 0
+              && header[4] == digest_cache_version
+              && crc32c::checksum(header, 28) == load_le<uint32_t>(header + 28)
+              && capacity != 0 && (capacity & (capacity - 1)) == 0
+              && (uint64_t)st.st_size == digest_cache_header_bytes + capacity*digest_cache_record_bytes;
+    if (!valid)
+    {
+        munmap(data, st.st_size);
+        return;
+    }
+
+    t.map(header, st.st_size, capacity, load_le<uint64_t>(header + 16));
+}
+
+// temporary files are only written with the writer lock held, so any that exist were left by a crash
+void digest_cache::remove_temp_files(const std::string& path)
+{
+    size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    std::string prefix = path.substr(slash == std::string::npos ? 0 : slash + 1) + ".tmp.";
+
+    DIR* d = opendir(dir.c_str());
+    if (d == nullptr)
+        return;
+    while (const struct dirent* entry = readdir(d))
+        if (std::strncmp(entry->d_name, prefix.c_str(), prefix.size()) == 0)
+            unlink((dir + "/" + entry->d_name).c_str());
+    closedir(d);
+}
+
+bool digest_cache::lookup(const file_key& key, std::string& digest) const
+{
+    std::string k = encode_key(key);
+
+    {
+        reader_guard guard(*this);
+        const table* t = guard.t;
+
+        if (t->capacity != 0)
+        {
+            uint64_t mask = t->capacity - 1;
+            uint64_t i = xxh3::hash64(k) & mask;
+            for (uint64_t probes = 0; probes < t->capacity; ++probes, i = (i + 1) & mask)
+            {
+                const uint8_t* record = t->slot(i);
+                if (record[32] == 0)
+                    break;
+                if (std::memcmp(record, k.data(), digest_cache_key_bytes) != 0)
+                    continue;
+                if (!valid_record(record))
+                    break;
+
+                // checked first so that repeated hits do not keep writing the shared word
+                std::atomic<uint64_t>& word = t->used[i / 64];
+                uint64_t bit = (uint64_t)1 << (i % 64);
+                if ((word.load(std::memory_order_relaxed) & bit) == 0)
+                    word.fetch_or(bit, std::memory_order_relaxed);
+
+                digest.assign((const char*)record + 36, record[digest_cache_key_bytes]);
+                return true;
+            }
+        }
+    }
+
+    std::lock_guard<std::mutex> lock(pending_mutex);
+    auto it = pending.find(k);
+    if (it == pending.end())
+        return false;
+    digest = it->second;
+    return true;
+}
+
+void digest_cache::insert(const file_key& key, const std::string& digest)
+{
+    if (digest.size() > 32)
+        throw std::invalid_argument("digest_cache: digest longer than 32 bytes");
+
+    bool request;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        pending[encode_key(key)] = digest;
+        request = pending.size() >= batch_size && !flush_requested;
+        if (request)
+            flush_requested = true;
+    }
+
+    if (request)
+        wake.notify_one();
+}
+
+std::string digest_cache::digest_file(const std::string& path, file_algorithm algorithm)
+{
+    struct stat st;
+    if (stat(path.c_str(), &st) == 0)
+    {
+        std::string digest;
+        if (lookup(make_file_key(st, algorithm), digest))
+        {
+            hits.fetch_add(1, std::memory_order_relaxed);
+            return bytes_to_hexcode(digest);
+        }
+    }
+    misses.fetch_add(1, std::memory_order_relaxed);
+
+    int fd = open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "digest_file: cannot open " + path);
+
+    std::string digest;
+    struct stat before, after;
+    try
+    {
+        if (fstat(fd, &before) != 0)
+            throw std::system_error(errno, std::generic_category(), "digest_file: cannot stat " + path);
+        digest = hash_fd(fd, algorithm, path);
+        if (fstat(fd, &after) != 0)
+            throw std::system_error(errno, std::generic_category(), "digest_file: cannot stat " + path);
+    }
+    catch (...)
+    {
+        close(fd);
+        throw;
+    }
+    close(fd);
+
+    // only cache regular files that did not change while being read and were not modified too recently
+    file_key key = make_file_key(before, algorithm);
+    file_key key_after = make_file_key(after, algorithm);
+    int64_t now_ns = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                         std::chrono::system_clock::now().time_since_epoch()).count();
+    if (S_ISREG(before.st_mode) && encode_key(key) == encode_key(key_after) && now_ns - key.mtime_ns >= digest_cache_racy_ns)
+        insert(key, digest);
+
+    return bytes_to_hexcode(digest);
+}
+
+void digest_cache::flush()
+{
+    std::lock_guard<std::mutex> flushing(flush_mutex);
+
+    std::unordered_map<std::string, std::string> batch;
+    {
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        batch.swap(pending);
+    }
+    if (batch.empty())
+        return;
+
+    try
+    {
+        write_table(batch);
+    }
+    catch (...)
+    {
+        // digests inserted since the swap are newer, keep those
+        std::lock_guard<std::mutex> lock(pending_mutex);
+        for (auto& entry : batch)
+            pending.insert(entry);
+        throw;
+    }
+}
+
+// background flushes requested by insert, a failed one leaves the digests pending for the next flush
+void digest_cache::run()
+{
+    std::unique_lock<std::mutex> lock(pending_mutex);
+    for (;;)
+    {
+        wake.wait(lock, [this] { return flush_requested || stopping; });
+        if (stopping)
+            return;
+
+        // cleared before flushing, so that a batch filled during this flush requests the next one
+        flush_requested = false;
+
+        lock.unlock();
+        try
+        {
+            flush();
+        }
+        catch (const std::system_error&)
+        {
+        }
+        lock.lock();
+    }
+}
+
+// a table object that is not in use, called with flush_mutex held
+digest_cache::table* digest_cache::spare_table()
+{
+    if (spare.empty())
+    {
+        tables.emplace_back(new table());
+        return tables.back().get();
+    }
+    table* t = spare.back();
+    spare.pop_back();
+    return t;
+}
+
+// merges the table on disk, the current table and batch into a new file and publishes it,
+// called with flush_mutex held
+void digest_cache::write_table(const std::unordered_map<std::string, std::string>& batch)
+{
+    writer_lock lock(path);
+    remove_temp_files(path);
+
+    int64_t today = std::chrono::duration_cast<std::chrono::hours>(
+                        std::chrono::system_clock::now().time_since_epoch()).count() / 24;
+
+    // one record per (device, inode, algorithm), since only the latest version of a file can match again:
+    // the digest just computed, otherwise the record with the newest mtime
+    struct record
+    {
+        std::string key;
+        std::string digest;
+        int64_t day;
+        bool fresh;
+    };
+    std::unordered_map<std::string, record> records;
+
+    auto file_id = [](const std::string& k) { return k.substr(0, 16) + k[32]; };
+    auto mtime = [](const std::string& k) { return (int64_t)load_le<uint64_t>((const uint8_t*)k.data() + 24); };
+
+    for (auto& entry : batch)
+        records[file_id(entry.first)] = {entry.first, entry.second, today, true};
+
+    auto merge = [&](const table& t, bool refresh_used)
+    {
+        for (uint64_t i = 0; i < t.capacity; ++i)
+        {
+            const uint8_t* slot = t.slot(i);
+            if (slot[32] == 0 || !valid_record(slot))
+                continue;
+
+            std::string k((const char*)slot, digest_cache_key_bytes);
+            bool used = refresh_used && (t.used[i / 64].load(std::memory_order_relaxed) >> (i % 64)) & 1;
+            int64_t day = used ? today : load_le<uint16_t>(slot + 34);
+            if (today - day > digest_cache_max_age_days)
+                continue;
+
+            auto it = records.find(file_id(k));
+            if (it == records.end())
+            {
+                records[file_id(k)] = {k, std::string((const char*)slot + 36, slot[digest_cache_key_bytes]), day, false};
+                continue;
+            }
+
+            record& r = it->second;
+            if (r.key == k)
+                r.day = std::max(r.day, day);
+            else if (!r.fresh && mtime(k) > mtime(r.key))
+                r = {k, std::string((const char*)slot + 36, slot[digest_cache_key_bytes]), day, false};
+        }
+    };
+
+    // current can only be replaced by this function, so it is safe to read here without a guard
+    // the table on disk may be newer than current if another cache has flushed since
+    table on_disk;
+    load(path, on_disk);
+    merge(*current.load(), true);
+    merge(on_disk, false);
+
+    // at most half full, so probe sequences stay short
+    uint64_t capacity = 64;
+    while (capacity < 2 * records.size())
+        capacity *= 2;
+
+    std::vector<uint8_t> image(digest_cache_header_bytes + capacity*digest_cache_record_bytes, 0);
+    std::memcpy(image.data(), "GVDC", 4);
+    image[4] = digest_cache_version;
+    store_le<uint64_t>(image.data() + 8, capacity);
+    store_le<uint64_t>(image.data() + 16, records.size());
+    store_le<uint32_t>(image.data() + 28, crc32c::checksum(image.data(), 28));
+
+    for (auto& entry : records)
+    {
+        const record& r = entry.second;
+        uint64_t i = xxh3::hash64(r.key) & (capacity - 1);
+        while (image[digest_cache_header_bytes + i*digest_cache_record_bytes + 32] != 0)
+            i = (i + 1) & (capacity - 1);
+
+        uint8_t* slot = image.data() + digest_cache_header_bytes + i*digest_cache_record_bytes;
+        std::memcpy(slot, r.key.data(), digest_cache_key_bytes);
+        slot[digest_cache_key_bytes] = (uint8_t)r.digest.size();
+        store_le<uint16_t>(slot + 34, (uint16_t)r.day);
+        std::memcpy(slot + 36, r.digest.data(), r.digest.size());
+        store_le<uint32_t>(slot + digest_cache_record_bytes - 4, crc32c::checksum(slot, digest_cache_record_bytes - 4));
+    }
+
+    // write a temporary file next to the table, then rename it into place
+    std::string tmp_path = path + ".tmp.XXXXXX";
+    int fd = mkstemp(&tmp_path[0]);
+    if (fd < 0)
+        throw std::system_error(errno, std::generic_category(), "digest_cache: cannot create " + tmp_path);
+
+    auto fail = [&](const std::string& what)
+    {
+        int err = errno;
+        close(fd);
+        unlink(tmp_path.c_str());
+        throw std::system_error(err, std::generic_category(), "digest_cache: cannot " + what + " " + tmp_path);
+    };
+
+    // mkstemp creates the file readable by its owner only
+    if (fcntl(fd, F_SETFD, FD_CLOEXEC) != 0 || fchmod(fd, 0644) != 0)
+        fail("set up");
+
+    for (size_t done = 0; done < image.size();)
+    {
+        ssize_t n = write(fd, image.data() + done, image.size() - done);
+        if (n < 0 && errno == EINTR)
+            continue;
+        if (n < 0)
+            fail("write");
+        done += n;
+    }
+    if (fsync(fd) != 0)
+        fail("fsync");
+
+    void* data = mmap(nullptr, image.size(), PROT_READ, MAP_SHARED, fd, 0);
+    if (data == MAP_FAILED)
+        fail("mmap");
+    close(fd);
+
+    if (rename(tmp_path.c_str(), path.c_str()) != 0)
+    {
+        int err = errno;
+        munmap(data, image.size());
+        unlink(tmp_path.c_str());
+        throw std::system_error(err, std::generic_category(), "digest_cache: cannot rename " + tmp_path);
+    }
+
+    // make the rename itself durable
+    size_t slash = path.find_last_of('/');
+    std::string dir = (slash == std::string::npos) ? "." : (slash == 0 ? "/" : path.substr(0, slash));
+    int dir_fd = open(dir.c_str(), O_RDONLY | O_CLOEXEC);
+    if (dir_fd >= 0)
+    {
+        fsync(dir_fd);
+        close(dir_fd);
+    }
+
+    table* t = spare_table();
+    t->map((const uint8_t*)data, image.size(), capacity, records.size());
+
+    table* old = current.exchange(t);
+    old->retired.store(true);
+    retired.push_back(old);
+    reclaim();
+}
+
+// unmaps retired tables that no lookup is reading, called with flush_mutex held
+// a lookup that counts in later finds that the table is no longer current and does not read it
+void digest_cache::reclaim() const
+{
+    for (size_t i = 0; i < retired.size();)
+    {
+        table* t = retired[i];
+        if (t->readers.load() != 0)
+        {
+            ++i;
+            continue;
+        }
+
+        t->unmap();
+        t->retired.store(false);
+        spare.push_back(t);
+        retired[i] = retired.back();
+        retired.pop_back();
+    }
+}
+
+uint64_t digest_cache::size() const
+{
+    reader_guard guard(*this);
+    return guard.t->count;
+}
+
+} // namespace gv
@@ -0,0 +1,113 @@
+#include <iostream>
+#include <cstdlib>
+#include "file_digest.hpp"
+
+// writes a file and backdates it an hour, so that the cache does not skip it as recently modified
+void write_old_file(const std::string& path, const std::string& contents) {
+    int fd = open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC, 0644);
+    if (fd < 0 || write(fd, contents.data(), contents.size()) != (ssize_t)contents.size())
+        throw std::system_error(errno, std::generic_category(), "cannot write " + path);
+    close(fd);
+
+    struct timespec times[2];
+    times[0].tv_sec = times[1].tv_sec = time(nullptr) - 3600;
+    times[0].tv_nsec = times[1].tv_nsec = 0;
+    utimensat(AT_FDCWD, path.c_str(), times, 0);
+}
+
+int main(int argc, char* argv[]) {
+    const char* tmp = std::getenv("TMPDIR");
+    std::string dir_template = std::string(tmp != nullptr ? tmp : "/tmp") + "/file_digest_test.XXXXXX";
+    if (mkdtemp(&dir_template[0]) == nullptr) {
+        std::cout << "cannot create a temporary directory" << std::endl;
+        return 1;
+    }
+    const std::string dir = dir_template;
+    const std::string cache_path = dir + "/cache";
+    const std::string file_a = dir + "/a", file_b = dir + "/b", stale_tmp = cache_path + ".tmp.crashed";
+
+    write_old_file(file_a, "first file");
+    write_old_file(file_b, "second file");
+    write_old_file(stale_tmp, "left by a crash");
+    std::string digest_a = gv::digest_file(file_a, gv::file_algorithm::sha1);
+    std::string digest_b = gv::digest_file(file_b, gv::file_algorithm::sha3_256);
+
+    bool ok = true;
+    {
+        // two caches on one table, the second flush merges in the first instead of replacing it
+        gv::digest_cache first(cache_path), second(cache_path);
+        first.digest_file(file_a, gv::file_algorithm::sha1);
+        second.digest_file(file_b, gv::file_algorithm::sha3_256);
+        first.flush();
+        second.flush();
+
+        gv::digest_cache third(cache_path);
+        bool hits = third.digest_file(file_a, gv::file_algorithm::sha1) == digest_a
+                    && third.digest_file(file_b, gv::file_algorithm::sha3_256) == digest_b && third.num_hits() == 2;
+        std::cout << "Two writers: " << third.size() << " records, " << third.num_hits() << " hits (should be 2 records, 2 hits)" << std::endl;
+        ok = ok && hits && third.size() == 2;
+
+        // a file rewritten in place replaces its old record rather than adding one
+        write_old_file(file_a, "first file, second version");
+        digest_a = gv::digest_file(file_a, gv::file_algorithm::sha1);
+        ok = ok && third.digest_file(file_a, gv::file_algorithm::sha1) == digest_a;
+        third.flush();
+        std::cout << "Rewritten file: " << third.size() << " records (should be 2)" << std::endl;
+        ok = ok && third.size() == 2;
+    }
+
+    bool stale_removed = access(stale_tmp.c_str(), F_OK) != 0;
+    std::cout << "Stale temporary file: " << (stale_removed ? "removed" : "KEPT") << " (should be removed)" << std::endl;
+    ok = ok && stale_removed;
+
+    {
+        // with a batch of one, the background thread flushes the first insert
+        write_old_file(file_b, "second file, second version");
+        gv::digest_cache cache(cache_path, 1);
+        cache.digest_file(file_b, gv::file_algorithm::sha1);
+        for (int i = 0; i < 200 && cache.size() != 3; ++i)
+            std::this_thread::sleep_for(std::chrono::milliseconds(10));
+        std::cout << "Background flush: " << cache.size() << " records (should be 3)" << std::endl;
+        ok = ok && cache.size() == 3;
+    }
+
+    if (argc > 1) {
+
+        std::string path(argv[1]);
+        std::string demo_path = dir + "/demo";
+
+        // a path that cannot be read, e.g. a missing file, is reported rather than ending the test
+        try {
+            std::string sha1_digest = gv::digest_file(path, gv::file_algorithm::sha1);
+            std::string sha3_digest = gv::digest_file(path, gv::file_algorithm::sha3_256);
+            std::cout << path << " >>>> SHA1 >>>> " << sha1_digest << std::endl;
+            std::cout << path << " >>>> SHA3-256 >>>> " << sha3_digest << std::endl;
+
+            // the first cache reads the file, the second finds its digest in the cache file
+            // (files modified in the last 2 seconds are never cached)
+            std::string cached;
+            {
+                gv::digest_cache cache(demo_path);
+                cache.digest_file(path, gv::file_algorithm::sha1);
+            }
+            gv::digest_cache cache(demo_path);
+            cached = cache.digest_file(path, gv::file_algorithm::sha1);
+
+            std::cout << path << " >>>> SHA1 (cached) >>>> " << cached << " (hits " << cache.num_hits()
+                      << ", misses " << cache.num_misses() << ")" << std::endl;
+        } catch (const std::system_error& e) {
+            std::cout << e.what() << std::endl;
+            ok = false;
+        }
+
+        unlink(demo_path.c_str());
+        unlink((demo_path + ".lock").c_str());
+
+    }
+
+    for (const std::string& file : {file_a, file_b, cache_path, cache_path + ".lock"})
+        unlink(file.c_str());
+    rmdir(dir.c_str());
+
+    return ok ? 0 : 1;
+}
@@ -0,0 +1,329 @@
+/*
+Auto-batching hash service
+
+William Denny
+
+    - Collects single-message hash requests from many threads and hashes them together with the
+      multi-buffer batch kernels (sha1::hash_batch, sha3_256::hash_batch)
+
+    - Submission is lock-free: requests are pushed onto an intrusive multi-producer single-consumer queue
+      (Vyukov) with a single atomic exchange. One worker thread drains the queue
+
+    - A batch is flushed as soon as a full group of SIMD lanes is waiting, or when the oldest waiting
+      request reaches max_delay, which bounds the latency added by batching
+
+    - Results are returned through a std::future or a callback. Callbacks run on the worker thread
+      and must not throw
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <future>
+#include <functional>
+#include <chrono>
+#include <algorithm>
+
+#ifdef __linux__
+#include <sys/prctl.h>
+#endif
+
+#include "crypto_useful.hpp"
+#include "sha1.hpp"
+#include "sha3_256.hpp"
+
+namespace gv
+{
+
+// **************************************************************************************************************
+// BATCH HASH ALGORITHMS
+// **************************************************************************************************************
+
+// each algorithm that can be used by hash_service provides its digest type, the number of lanes
+// in its multi-buffer kernel and a batch hashing function
+
+struct sha1_batch
+{
+    using digest_type = sha1_digest;
+
+    static const uint32_t lanes = sha1_lanes;
+
+    static std::vector<digest_type> hash_batch(const std::vector<std::string>& strs) { return sha1::hash_batch(strs); }
+};
+
+struct sha3_256_batch
+{
+    using digest_type = sha3_256::digest_t;
+
+    static const uint32_t lanes = sha3_256::lanes;
+
+    static std::vector<digest_type> hash_batch(const std::vector<std::string>& strs) { return sha3_256::hash_batch(strs); }
+};
+
+// **************************************************************************************************************
+// HASH SERVICE
+// **************************************************************************************************************
+
+template <typename Algorithm>
+class hash_service
+{
+
+public:
+    using digest_type = typename Algorithm::digest_type;
+    using callback = std::function<void(const digest_type&)>;
+
+    // max_delay is the longest a request waits for others to fill its batch
+    // max_batch is the most messages passed to one call of the batch kernel (rounded up to whole lane groups)
+    hash_service(std::chrono::microseconds max_delay = std::chrono::microseconds(100), size_t max_batch = 8 * Algorithm::lanes);
+
+    // finishes all submitted requests before returning
+    ~hash_service();
+
+    hash_service(const hash_service&) = delete;
+    hash_service& operator=(const hash_service&) = delete;
+
+    std::future<digest_type> submit(std::string str);
+    void submit(std::string str, callback cb);
+
+    // number of batch kernel calls so far, for tuning max_delay
+    uint64_t num_batches() const { return batches.load(std::memory_order_relaxed); }
+
+private:
+    struct request
+    {
+        std::string str;
+        std::promise<digest_type> promise;
+        callback cb;
+        std::chrono::steady_clock::time_point submitted;
+        std::atomic<request*> next{nullptr};
+    };
+
+    std::chrono::microseconds max_delay;
+    size_t max_batch;
+
+    // MPSC queue, producers exchange head, the worker owns tail
+    // stub is a dummy node so the queue is never empty of nodes
+    std::atomic<request*> head;
+    request* tail;
+    request stub;
+
+    // the mutex is only taken to sleep or to wake a sleeping worker, never to submit
+    std::mutex sleep_mutex;
+    std::condition_variable wake;
+    std::atomic<bool> sleeping{false};
+    std::atomic<bool> stopping{false};
+
+    std::atomic<uint64_t> batches{0};
+
+    std::thread worker;
+
+    void push(request* r);
+    request* pop();
+
+    void run();
+    void flush(std::vector<request*>& pending);
+};
+
+template <typename Algorithm>
+hash_service<Algorithm>::hash_service(std::chrono::microseconds max_delay, size_t max_batch)
+    : max_delay(max_delay), head(&stub), tail(&stub)
+{
+    // whole lane groups only, so that no lanes are wasted when the batch is full
+    this->max_batch = ((max_batch + Algorithm::lanes - 1) / Algorithm::lanes) * Algorithm::lanes;
+    if (this->max_batch == 0)
+        this->max_batch = Algorithm::lanes;
+
+    worker = std::thread(&hash_service::run, this);
+}
+
+template <typename Algorithm>
+hash_service<Algorithm>::~hash_service()
+{
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        stopping.store(true);
+    }
+    wake.notify_one();
+    worker.join();
+}
+
+template <typename Algorithm>
+void hash_service<Algorithm>::push(request* r)
+{
+    r->next.store(nullptr, std::memory_order_relaxed);
+    // seq_cst pairs with the worker storing sleeping then reading head, so one of the two sees the other
+    request* prev = head.exchange(r);
+    prev->next.store(r, std::memory_order_release);
+
+    // wake the worker only if it is (about to be) asleep
+    if (sleeping.load())
+    {
+        std::lock_guard<std::mutex> lock(sleep_mutex);
+        wake.notify_one();
+    }
+}
+
+// returns the oldest request, or nullptr if the queue is empty or a push is half way through
+template <typename Algorithm>
+typename hash_service<Algorithm>::request* hash_service<Algorithm>::pop()
+{
+    request* t = tail;
+    request* next = t->next.load(std::memory_order_acquire);
+
+    if (t == &stub)
+    {
+        if (next == nullptr)
+            return nullptr;
+        tail = next;
+        t = next;
+        next = next->next.load(std::memory_order_acquire);
+    }
+
+    if (next != nullptr)
+    {
+        tail = next;
+        return t;
+    }
+
+    // t is the last node, it can only be taken once the stub is queued behind it
+    if (t != head.load(std::memory_order_acquire))
+        return nullptr;
+
+    stub.next.store(nullptr, std::memory_order_relaxed);
+    request* prev = head.exchange(&stub, std::memory_order_acq_rel);
+    prev->next.store(&stub, std::memory_order_release);
+
+    next = t->next.load(std::memory_order_acquire);
+    if (next != nullptr)
+    {
+        tail = next;
+        return t;
+    }
+    return nullptr;
+}
+
+template <typename Algorithm>
+std::future<typename hash_service<Algorithm>::digest_type> hash_service<Algorithm>::submit(std::string str)
+{
+    request* r = new request;
+    r->str = std::move(str);
+    r->submitted = std::chrono::steady_clock::now();
+    std::future<digest_type> result = r->promise.get_future();
+    push(r);
+    return result;
+}
+
+template <typename Algorithm>
+void hash_service<Algorithm>::submit(std::string str, callback cb)
+{
+    request* r = new request;
+    r->str = std::move(str);
+    r->cb = std::move(cb);
+    r->submitted = std::chrono::steady_clock::now();
+    push(r);
+}
+
+template <typename Algorithm>
+void hash_service<Algorithm>::flush(std::vector<request*>& pending)
+{
+    std::vector<std::string> strs(pending.size());
+    for (size_t i = 0; i < pending.size(); ++i)
+        strs[i] = std::move(pending[i]->str);
+
+    std::vector<digest_type> digests = Algorithm::hash_batch(strs);
+    batches.fetch_add(1, std::memory_order_relaxed);
+
+    for (size_t i = 0; i < pending.size(); ++i)
+    {
+        if (pending[i]->cb)
+            pending[i]->cb(digests[i]);
+        else
+            pending[i]->promise.set_value(digests[i]);
+        delete pending[i];
+    }
+    pending.clear();
+}
+
+template <typename Algorithm>
+void hash_service<Algorithm>::run()
+{
+    // only the last stretch before a request is due is spun, since waking from a sleep can overshoot it
+    // the window is a small fraction of max_delay with a fixed cap, so the worker mostly sleeps
+    const std::chrono::microseconds spin_limit = std::min(max_delay / 8, std::chrono::microseconds(20));
+
+#ifdef __linux__
+    // the default timer slack (50us) would make every timed wait overshoot a short max_delay
+    prctl(PR_SET_TIMERSLACK, 1000, 0, 0, 0);
+#endif
+
+    std::vector<request*> pending;
+    pending.reserve(max_batch);
+
+    while (true)
+    {
+        // take everything available, up to one batch
+        while (pending.size() < max_batch)
+        {
+            request* r = pop();
+            if (r == nullptr)
+                break;
+            pending.push_back(r);
+        }
+
+        bool stop = stopping.load();
+        auto now = std::chrono::steady_clock::now();
+
+        // flush once every lane of a group is filled, when the oldest request is due, or when shutting down
+        if (!pending.empty())
+        {
+            bool full = pending.size() >= max_batch || pending.size() % Algorithm::lanes == 0;
+            bool due = now >= pending.front()->submitted + max_delay;
+            if (full || due || stop)
+            {
+                flush(pending);
+                continue;
+            }
+        }
+        else if (stop)
+        {
+            // a producer may still be half way through a push, so only exit once the queue is drained
+            if (tail == &stub && stub.next.load() == nullptr && head.load() == &stub)
+                return;
+            std::this_thread::yield();
+            continue;
+        }
+
+        // wait for more requests, at most until the oldest pending request is due
+        if (!pending.empty() && pending.front()->submitted + max_delay - now <= spin_limit)
+        {
+            std::this_thread::yield();
+            continue;
+        }
+
+        std::unique_lock<std::mutex> lock(sleep_mutex);
+        sleeping.store(true);
+
+        // a request pushed before sleeping was set would not notify, so check the queue again
+        if (tail->next.load() != nullptr || head.load() != tail || stopping.load())
+        {
+            sleeping.store(false);
+            continue;
+        }
+
+        if (pending.empty())
+            wake.wait(lock);
+        else
+            wake.wait_until(lock, pending.front()->submitted + max_delay - spin_limit);
+        sleeping.store(false);
+    }
+}
+
+} // namespace gv
@@ -0,0 +1,125 @@
+#include <iostream>
+#include <thread>
+#include "hash_service.hpp"
+
+const int num_threads = 8;
+const int requests_per_thread = 250;
+
+// submits from several threads through futures and callbacks and checks every digest against the single
+// message hash, then checks the latency of a lone request and that the destructor finishes pending requests
+template <typename Algorithm, typename Hash>
+int check_service(const std::string& name, Hash hash)
+{
+    using digest_type = typename Algorithm::digest_type;
+    int num_wrong = 0;
+
+    std::vector<std::string> messages;
+    for (int i = 0; i < num_threads * requests_per_thread; ++i)
+        messages.push_back(std::string(i % 300, (char)('a' + i % 26)) + std::to_string(i));
+
+    // even requests use a future, odd ones a callback
+    std::vector<std::future<digest_type>> futures(messages.size());
+    std::vector<digest_type> called_back(messages.size());
+    std::atomic<int> num_called_back{0};
+    uint64_t num_batches;
+    {
+        gv::hash_service<Algorithm> service;
+
+        std::vector<std::thread> threads;
+        for (int t = 0; t < num_threads; ++t) {
+            threads.emplace_back([&, t]() {
+                for (int k = 0; k < requests_per_thread; ++k) {
+                    size_t i = t * requests_per_thread + k;
+                    if (i % 2 == 0)
+                        futures[i] = service.submit(messages[i]);
+                    else
+                        service.submit(messages[i], [&, i](const digest_type& d) { called_back[i] = d; ++num_called_back; });
+                }
+            });
+        }
+        for (std::thread& t : threads)
+            t.join();
+
+        for (size_t i = 0; i < messages.size(); i += 2)
+            futures[i].wait();
+        while (num_called_back.load() != (int)messages.size() / 2)
+            std::this_thread::yield();
+        num_batches = service.num_batches();
+    }
+
+    for (size_t i = 0; i < messages.size(); ++i) {
+        digest_type got = (i % 2 == 0) ? futures[i].get() : called_back[i];
+        if (got != hash(messages[i]))
+            ++num_wrong;
+    }
+    std::cout << name << ": " << num_wrong << " wrong of " << messages.size() << " in " << num_batches
+              << " batches (should be 0 wrong, fewer batches than requests)" << std::endl;
+    if (num_batches >= messages.size())
+        ++num_wrong;
+
+    // a request that no other request joins is flushed once it has waited max_delay
+    {
+        std::chrono::microseconds max_delay(2000);
+        gv::hash_service<Algorithm> service(max_delay);
+        auto start = std::chrono::steady_clock::now();
+        std::future<digest_type> lone = service.submit("lone");
+        bool ready = lone.wait_for(max_delay + std::chrono::milliseconds(50)) == std::future_status::ready;
+        auto waited = std::chrono::duration_cast<std::chrono::microseconds>(std::chrono::steady_clock::now() - start);
+        std::cout << name << ": lone request took " << waited.count() << " us (should be about " << max_delay.count() << " us)" << std::endl;
+        if (!ready || lone.get() != hash("lone"))
+            ++num_wrong;
+    }
+
+    // with a max_delay far longer than the test, only the destructor can finish these
+    std::vector<std::future<digest_type>> pending;
+    std::atomic<int> num_pending_called_back{0};
+    {
+        gv::hash_service<Algorithm> service(std::chrono::seconds(60));
+        for (int i = 0; i < 3; ++i) {
+            pending.push_back(service.submit(messages[i]));
+            service.submit(messages[i], [&](const digest_type&) { ++num_pending_called_back; });
+        }
+    }
+    int num_finished = num_pending_called_back.load();
+    for (size_t i = 0; i < pending.size(); ++i)
+        if (pending[i].wait_for(std::chrono::seconds(0)) == std::future_status::ready && pending[i].get() == hash(messages[i]))
+            ++num_finished;
+    std::cout << name << ": destructor finished " << num_finished << " of 6 pending requests" << std::endl;
+    if (num_finished != 6)
+        ++num_wrong;
+
+    return num_wrong;
+}
+
+int main(int argc, char* argv[]) {
+    int num_wrong = check_service<gv::sha1_batch>("SHA-1", [](const std::string& s) { return gv::sha1::hash(s); })
+                  + check_service<gv::sha3_256_batch>("SHA3-256", [](const std::string& s) { return gv::sha3_256::hash(s); });
+
+    // each input is submitted from its own thread, the service hashes them together in batches
+    if (argc > 1) {
+
+        gv::hash_service<gv::sha1_batch> sha1_service;
+        gv::hash_service<gv::sha3_256_batch> sha3_service;
+
+        std::vector<std::future<gv::sha1_digest>> sha1_results(argc - 1);
+        std::vector<std::future<gv::sha3_256::digest_t>> sha3_results(argc - 1);
+
+        std::vector<std::thread> threads;
+        for (int i = 1; i < argc; ++i) {
+            threads.emplace_back([&, i]() {
+                sha1_results[i - 1] = sha1_service.submit(std::string(argv[i]));
+                sha3_results[i - 1] = sha3_service.submit(std::string(argv[i]));
+            });
+        }
+        for (std::thread& t : threads) {
+            t.join();
+        }
+
+        for (int i = 1; i < argc; ++i) {
+            std::cout << argv[i] << " >>>> SHA-1 >>>> " << gv::bytes_to_hexcode(sha1_results[i - 1].get()) << std::endl;
+            std::cout << argv[i] << " >>>> SHA3-256 >>>> " << gv::bytes_to_hexcode(sha3_results[i - 1].get()) << std::endl;
+        }
+    }
+
+    return num_wrong == 0 ? 0 : 1;
+}
@@ -0,0 +1,368 @@
+/*
+Hashcash proof of work
+
+William Denny
+
+    - A stamp is a prefix (the challenge) followed by a nonce written as 16 lowercase hex digits.
+      It is valid if its SHA-1 or SHA3-256 digest starts with at least the required number of zero bits
+
+    - The solver absorbs the whole blocks of the prefix once, then only re-hashes the final block(s)
+      holding the nonce, starting from the saved midstate. Candidates are hashed in parallel on the
+      lanes of the multi-buffer kernels (8 for SHA-1, 4 for SHA3-256) and on every core
+
+    - Nonces are handed out in increasing order, so the solver returns the smallest valid nonce
+      and stops once no smaller one can be found
+
+    - Verifying a stamp is a single hash
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <atomic>
+#include <thread>
+#include <stdexcept>
+
+#include "crypto_useful.hpp"
+#include "sha1.hpp"
+#include "sha3_256.hpp"
+
+namespace gv
+{
+
+namespace hashcash
+{
+
+//********************************************************************************************************************
+
+// DATATYPES
+
+enum class algorithm
+{
+    sha1,
+    sha3_256
+};
+
+// number of hex digits the nonce is written with
+const uint32_t nonce_digits = 16;
+
+//********************************************************************************************************************
+
+// FUNCTION DECLARATIONS
+
+// finds the smallest nonce <= max_nonce such that prefix + nonce_string(nonce) has at least bits leading zero bits
+// returns false if there is none, num_threads = 0 uses every core
+// throws std::invalid_argument if bits is larger than the digest
+bool solve(algorithm algo, const std::string& prefix, uint32_t bits, uint64_t& nonce,
+           uint32_t num_threads = 0, uint64_t max_nonce = ~(uint64_t)0);
+
+// checks a stamp with one hash
+bool verify(algorithm algo, const std::string& prefix, uint64_t nonce, uint32_t bits);
+
+// the nonce as it appears in the stamp
+std::string nonce_string(uint64_t nonce);
+
+template <size_t N>
+uint32_t leading_zero_bits(const std::array<uint8_t, N>& digest);
+
+//********************************************************************************************************************
+
+// BLOCK KERNELS
+
+// each algorithm provides its midstate, padding and a function that finishes the hash of several
+// candidates at once, all sharing the same midstate and number of final blocks
+
+struct sha1_kernel
+{
+    using state_type = sha1_state;
+    using digest_type = sha1_digest;
+
+    static const uint32_t block_bytes = 64;
+    static const uint32_t lanes = sha1_lanes;
+
+    static state_type initial() { return {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0}; }
+
+    static void absorb(state_type& state, const uint8_t* block) { sha1::compress(state, block); }
+
+    static std::vector<uint8_t> pad(const uint8_t* tail, size_t tail_len, uint64_t msg_len)
+    {
+        return md_pad(tail, tail_len, msg_len, block_bytes, 8);
+    }
+
+    static digest_type finish(state_type state, const uint8_t* blocks, size_t num_blocks)
+    {
+        for (size_t b = 0; b < num_blocks; ++b)
+            sha1::compress(state, blocks + block_bytes*b);
+        return sha1::to_digest(state);
+    }
+
+    static void finish_lanes(const state_type& state, const uint8_t* const blocks[lanes], size_t num_blocks, digest_type out[lanes])
+    {
+#ifdef GV_X86_DISPATCH
+        if (cpu().avx2)
+        {
+            alignas(32) sha1_word lane_state[5][8];
+            for (int w = 0; w < 5; ++w)
+                for (uint32_t l = 0; l < lanes; ++l)
+                    lane_state[w][l] = state[w];
+
+            for (size_t b = 0; b < num_blocks; ++b)
+            {
+                const uint8_t* lane_blocks[lanes];
+                for (uint32_t l = 0; l < lanes; ++l)
+                    lane_blocks[l] = blocks[l] + block_bytes*b;
+                sha1::compress_avx2_x8(lane_state, lane_blocks, 0xff);
+            }
+
+            for (uint32_t l = 0; l < lanes; ++l)
+                out[l] = sha1::to_digest({lane_state[0][l], lane_state[1][l], lane_state[2][l], lane_state[3][l], lane_state[4][l]});
+            return;
+        }
+#endif
+        for (uint32_t l = 0; l < lanes; ++l)
+            out[l] = finish(state, blocks[l], num_blocks);
+    }
+};
+
+struct sha3_256_kernel
+{
+    using state_type = sha3_256::state_t;
+    using digest_type = sha3_256::digest_t;
+
+    static const uint32_t block_bytes = sha3_256::block_bytes;
+    static const uint32_t lanes = sha3_256::lanes;
+
+    static state_type initial() { return {}; }
+
+    static void absorb(state_type& state, const uint8_t* block)
+    {
+        sha3_256::absorb_block(state, block);
+        sha3_256::keccak_f(state);
+    }
+
+    // the sponge padding does not encode the message length
+    static std::vector<uint8_t> pad(const uint8_t* tail, size_t tail_len, uint64_t)
+    {
+        return sha3_pad(tail, tail_len, block_bytes);
+    }
+
+    static digest_type finish(state_type state, const uint8_t* blocks, size_t num_blocks)
+    {
+        for (size_t b = 0; b < num_blocks; ++b)
+            absorb(state, blocks + block_bytes*b);
+        return sha3_256::squeeze(state);
+    }
+
+    static void finish_lanes(const state_type& state, const uint8_t* const blocks[lanes], size_t num_blocks, digest_type out[lanes])
+    {
+#ifdef GV_X86_DISPATCH
+        if (cpu().avx2)
+        {
+            alignas(32) uint64_t lane_state[25][4];
+            for (int i = 0; i < 25; ++i)
+                for (uint32_t l = 0; l < lanes; ++l)
+                    lane_state[i][l] = state[i];
+
+            for (size_t b = 0; b < num_blocks; ++b)
+            {
+                const uint8_t* lane_blocks[lanes];
+                for (uint32_t l = 0; l < lanes; ++l)
+                    lane_blocks[l] = blocks[l] + block_bytes*b;
+                sha3_256::absorb_avx2_x4(lane_state, lane_blocks, 0xf);
+            }
+
+            for (uint32_t l = 0; l < lanes; ++l)
+            {
+                state_type final_state = {};
+                for (int i = 0; i < 4; ++i)
+                    final_state[i] = lane_state[i][l];
+                out[l] = sha3_256::squeeze(final_state);
+            }
+            return;
+        }
+#endif
+        for (uint32_t l = 0; l < lanes; ++l)
+            out[l] = finish(state, blocks[l], num_blocks);
+    }
+};
+
+//********************************************************************************************************************
+
+// SOLVER
+
+// the blocks left to hash after the prefix midstate, with the nonce at nonce_offset
+template <typename Kernel>
+struct final_blocks
+{
+    typename Kernel::state_type midstate;
+    std::vector<uint8_t> blocks;
+    size_t num_blocks;
+    size_t nonce_offset;
+
+    final_blocks(const std::string& prefix)
+    {
+        const uint8_t* data = (const uint8_t*)prefix.data();
+        size_t num_prefix_blocks = prefix.size() / Kernel::block_bytes;
+
+        midstate = Kernel::initial();
+        for (size_t b = 0; b < num_prefix_blocks; ++b)
+            Kernel::absorb(midstate, data + Kernel::block_bytes*b);
+
+        // the rest of the prefix, then room for the nonce
+        nonce_offset = prefix.size() % Kernel::block_bytes;
+        std::vector<uint8_t> rest(data + Kernel::block_bytes*num_prefix_blocks, data + prefix.size());
+        rest.resize(nonce_offset + nonce_digits, '0');
+
+        // the nonce may push the rest past a block boundary, that block is kept whole and the remainder padded
+        size_t whole = (rest.size() / Kernel::block_bytes) * Kernel::block_bytes;
+        std::vector<uint8_t> padded = Kernel::pad(rest.data() + whole, rest.size() - whole, prefix.size() + nonce_digits);
+
+        blocks.assign(rest.begin(), rest.begin() + whole);
+        blocks.insert(blocks.end(), padded.begin(), padded.end());
+        num_blocks = blocks.size() / Kernel::block_bytes;
+    }
+};
+
+inline void write_nonce(uint8_t* p, uint64_t nonce)
+{
+    const char* hex = "0123456789abcdef";
+    for (int i = nonce_digits - 1; i >= 0; --i, nonce >>= 4)
+        p[i] = hex[nonce & 0xf];
+}
+
+// nonces are taken in chunks from next, and best holds the smallest solution found so far
+template <typename Kernel>
+void solve_thread(const final_blocks<Kernel>& work, uint32_t bits, uint64_t max_nonce, uint64_t chunk,
+                  std::atomic<uint64_t>& next, std::atomic<uint64_t>& best)
+{
+    const uint32_t lanes = Kernel::lanes;
+
+    std::vector<uint8_t> lane_blocks[lanes];
+    const uint8_t* lane_ptrs[lanes];
+    for (uint32_t l = 0; l < lanes; ++l)
+    {
+        lane_blocks[l] = work.blocks;
+        lane_ptrs[l] = lane_blocks[l].data();
+    }
+
+    typename Kernel::digest_type digests[lanes];
+
+    while (true)
+    {
+        uint64_t start = next.fetch_add(chunk, std::memory_order_relaxed);
+
+        // chunks are handed out in order, so once one starts past a solution no smaller solution is left
+        if (start > max_nonce || start >= best.load(std::memory_order_relaxed))
+            return;
+
+        uint64_t end = (max_nonce - start < chunk) ? max_nonce + 1 : start + chunk;
+
+        for (uint64_t n = start; n < end; n += lanes)
+        {
+            for (uint32_t l = 0; l < lanes; ++l)
+                write_nonce(lane_blocks[l].data() + work.nonce_offset, n + l);
+
+            Kernel::finish_lanes(work.midstate, lane_ptrs, work.num_blocks, digests);
+
+            for (uint32_t l = 0; l < lanes; ++l)
+            {
+                if (n + l < end && leading_zero_bits(digests[l]) >= bits)
+                {
+                    // keep the smallest
+                    uint64_t found = n + l;
+                    uint64_t current = best.load();
+                    while (found < current && !best.compare_exchange_weak(current, found))
+                        ;
+                    return;
+                }
+            }
+        }
+    }
+}
+
+template <typename Kernel>
+bool solve(const std::string& prefix, uint32_t bits, uint64_t& nonce, uint32_t num_threads, uint64_t max_nonce)
+{
+    if (bits > 8 * sizeof(typename Kernel::digest_type))
+        throw std::invalid_argument("hashcash: more zero bits required than the digest has");
+
+    if (num_threads == 0)
+        num_threads = std::thread::hardware_concurrency();
+    if (num_threads == 0)
+        num_threads = 1;
+
+    // ~0 marks that no solution was found, so it is never tried
+    if (max_nonce == ~(uint64_t)0)
+        max_nonce -= 1;
+
+    final_blocks<Kernel> work(prefix);
+
+    // a multiple of the lanes, large enough that threads rarely contend for the counter
+    const uint64_t chunk = 1024 * Kernel::lanes;
+
+    std::atomic<uint64_t> next{0};
+    std::atomic<uint64_t> best{~(uint64_t)0};
+
+    std::vector<std::thread> threads;
+    for (uint32_t t = 1; t < num_threads; ++t)
+        threads.emplace_back(solve_thread<Kernel>, std::cref(work), bits, max_nonce, chunk, std::ref(next), std::ref(best));
+    solve_thread<Kernel>(work, bits, max_nonce, chunk, next, best);
+    for (std::thread& t : threads)
+        t.join();
+
+    uint64_t found = best.load();
+    if (found == ~(uint64_t)0)
+        return false;
+
+    nonce = found;
+    return true;
+}
+
+//********************************************************************************************************************
+
+template <size_t N>
+uint32_t leading_zero_bits(const std::array<uint8_t, N>& digest)
+{
+    uint32_t zeros = 0;
+    for (size_t i = 0; i < N; ++i)
+    {
+        if (digest[i] != 0)
+        {
+            for (uint8_t b = digest[i]; (b & 0x80) == 0; b <<= 1)
+                ++zeros;
+            return zeros;
+        }
+        zeros += 8;
+    }
+    return zeros;
+}
+
+std::string nonce_string(uint64_t nonce)
+{
+    std::string str(nonce_digits, '0');
+    write_nonce((uint8_t*)&str[0], nonce);
+    return str;
+}
+
+bool solve(algorithm algo, const std::string& prefix, uint32_t bits, uint64_t& nonce, uint32_t num_threads, uint64_t max_nonce)
+{
+    if (algo == algorithm::sha1)
+        return solve<sha1_kernel>(prefix, bits, nonce, num_threads, max_nonce);
+    return solve<sha3_256_kernel>(prefix, bits, nonce, num_threads, max_nonce);
+}
+
+bool verify(algorithm algo, const std::string& prefix, uint64_t nonce, uint32_t bits)
+{
+    std::string stamp = prefix + nonce_string(nonce);
+    if (algo == algorithm::sha1)
+        return leading_zero_bits(sha1::hash(stamp)) >= bits;
+    return leading_zero_bits(sha3_256::hash(stamp)) >= bits;
+}
+
+} // namespace hashcash
+
+} // namespace gv
@@ -0,0 +1,63 @@
+#include <iostream>
+#include "hashcash.hpp"
+
+// the smallest nonce that verify accepts, found one nonce at a time
+uint64_t linear_solve(gv::hashcash::algorithm algo, const std::string& prefix, uint32_t bits)
+{
+    uint64_t nonce = 0;
+    while (!gv::hashcash::verify(algo, prefix, nonce, bits))
+        ++nonce;
+    return nonce;
+}
+
+// solves with one and with several threads for every prefix length in [first_len, last_len] and compares with
+// the linear scan, these lengths move the nonce across the last block boundary of the prefix
+int check_solve(gv::hashcash::algorithm algo, const std::string& name, size_t first_len, size_t last_len, uint32_t bits)
+{
+    int num_wrong = 0;
+    for (size_t len = first_len; len <= last_len; ++len) {
+        std::string prefix(len, (char)('a' + len % 26));
+        uint64_t expected = linear_solve(algo, prefix, bits);
+
+        for (uint32_t num_threads : {1u, 4u}) {
+            uint64_t nonce = ~(uint64_t)0;
+            if (!gv::hashcash::solve(algo, prefix, bits, nonce, num_threads) || nonce != expected) {
+                std::cout << name << ", " << len << "-byte prefix, " << num_threads << " threads: " << nonce
+                          << " (should be " << expected << ")" << std::endl;
+                ++num_wrong;
+            }
+        }
+
+        // expected is the smallest solution, so a search that stops just below it finds nothing
+        uint64_t nonce;
+        bool found_at = gv::hashcash::solve(algo, prefix, bits, nonce, 4, expected) && nonce == expected;
+        bool found_below = expected > 0 && gv::hashcash::solve(algo, prefix, bits, nonce, 4, expected - 1);
+        if (!found_at || found_below) {
+            std::cout << name << ", " << len << "-byte prefix: max_nonce not respected" << std::endl;
+            ++num_wrong;
+        }
+    }
+    return num_wrong;
+}
+
+int main(int argc, char* argv[]) {
+    // prefixes whose nonce straddles the end of the first SHA-1 block and of the first SHA3-256 block
+    int num_wrong = check_solve(gv::hashcash::algorithm::sha1, "SHA-1", 48, 63, 12)
+                  + check_solve(gv::hashcash::algorithm::sha3_256, "SHA3-256", 120, 135, 12);
+    std::cout << "Solve against a linear scan: " << num_wrong << " wrong" << std::endl;
+
+    // solves a 20-bit SHA-1 stamp for the input, then checks it
+    if (argc > 1) {
+
+        std::string prefix(argv[1]);
+        uint64_t nonce;
+
+        if (gv::hashcash::solve(gv::hashcash::algorithm::sha1, prefix, 20, nonce)) {
+            std::string stamp = prefix + gv::hashcash::nonce_string(nonce);
+            std::cout << stamp << " >>>> SHA1 >>>> " << gv::sha1::digest(stamp) << std::endl;
+            std::cout << "valid: " << gv::hashcash::verify(gv::hashcash::algorithm::sha1, prefix, nonce, 20) << std::endl;
+        }
+    }
+
+    return num_wrong == 0 ? 0 : 1;
+}
@@ -15,9 +15,10 @@ William Denny
 #include <string>
 #include <bitset>
 #include <array>
+#include <string_view>
+#include <utility>
+#include <cstring>
 #include <assert.h>
-#include <sstream>
-#include <iomanip>
 
 #include "crypto_useful.hpp"
 
@@ -36,6 +37,13 @@ using sha1_word = uint32_t;
 
 using sha1_len = uint64_t;
 
+using sha1_state = std::array<sha1_word, 5>;
+
+using sha1_digest = std::array<uint8_t, 20>;
+
+// number of messages hashed together by the multi-buffer backend
+const uint32_t sha1_lanes = 8;
+
 // **************************************************************************************************************
 
 class sha1
@@ -46,13 +54,103 @@ public:
 
     static std::string digest(const std::string& str);
 
+    // computes the digest as raw bytes, can be evaluated at compile time
+    // e.g. constexpr gv::sha1_digest d = gv::sha1::hash("hello");
+    static constexpr sha1_digest hash(std::string_view str);
+
+    // processes a single 512-bit block of big-endian words
+    static constexpr void compress(sha1_state& H, const uint8_t* block);
+
+    // expands a 512-bit block into the 80-word message schedule
+    static constexpr std::array<sha1_word, 80> expand(const uint8_t* block);
+
+    // runs steps [first, last) of the compression function on the working variables A, B, C, D, E
+    static constexpr void steps(sha1_state& V, const std::array<sha1_word, 80>& word_seq, int first, int last);
+
+    // undoes steps [first, last) of the compression function, i.e. the inverse of steps
+    static constexpr void unsteps(sha1_state& V, const std::array<sha1_word, 80>& word_seq, int first, int last);
+
+    // collision detection (counter-cryptanalysis, as in Stevens & Shumow's sha1dc)
+    // compresses the block like compress, and returns true if the block looks like one half of a
+    // collision built from a known disturbance vector (e.g. SHAttered)
+    // when safe_hash is set a flagged block is compressed two more times, so the result no longer
+    // equals the digest shared by the colliding messages
+    static bool compress_checked(sha1_state& H, const uint8_t* block, bool safe_hash = true);
+
+    // hashes like hash, collision is set if any block was flagged by compress_checked
+    static sha1_digest hash_checked(std::string_view str, bool& collision, bool safe_hash = true);
+
+    // hashes each string, using the AVX2 multi-buffer backend (8 messages at once) where available
+    static std::vector<sha1_digest> hash_batch(const std::vector<std::string>& strs);
+    static std::vector<std::string> digest_batch(const std::vector<std::string>& strs);
+
     static std::vector<sha1_word> preprocess_str(const std::string& str);
 
-    static sha1_word f(const sha1_word& t, const sha1_word& B, const sha1_word& C, const sha1_word& D);
-    static sha1_word K(const sha1_word& t);
+    static constexpr sha1_word f(const sha1_word& t, const sha1_word& B, const sha1_word& C, const sha1_word& D);
+    static constexpr sha1_word K(const sha1_word& t);
+
+    // converts the final hash state to the big-endian digest bytes
+    static constexpr sha1_digest to_digest(const sha1_state& H);
+
+    // streaming interface for messages that arrive in pieces
+    class context;
+
+#ifdef GV_X86_DISPATCH
+    // compresses one block for each of 8 lanes, the state is stored word-major (state[word][lane])
+    // lanes with their bit clear in active keep their previous state
+    static void compress_avx2_x8(sha1_word state[5][8], const uint8_t* const blocks[8], uint32_t active);
+#endif
 
 };
 
+// streaming SHA-1
+// the midstate can be saved with export_state and resumed with import_state, so that a growing
+// message (e.g. an append-only file) only needs its new bytes hashed
+class sha1::context
+{
+
+public:
+    context() = default;
+
+    void update(const uint8_t* data, size_t len);
+    void update(std::string_view str) { update((const uint8_t*)str.data(), str.size()); }
+
+    // digest of everything hashed so far, the context can still be updated afterwards
+    sha1_digest finalize() const;
+
+    // as finalize, collision_out is set if any block so far (including the padding) was flagged
+    sha1_digest finalize(bool& collision_out) const;
+    std::string digest() const { return bytes_to_hexcode(finalize()); }
+
+    // number of message bytes hashed so far, i.e. the offset to resume from
+    sha1_len length() const { return msg_len; }
+
+    // serialises H0 .. H4, the message length and the partial block (format in crypto_useful.hpp)
+    std::string export_state() const;
+
+    // throws std::invalid_argument if data is not a valid SHA-1 midstate
+    static context import_state(const std::string& data);
+
+    // checks every block from now on with compress_checked, this setting is not part of the midstate
+    void detect_collisions(bool safe_hash = true) { check = true; safe = safe_hash; }
+
+    // true once a block completed by update has been flagged, the padding blocks are only checked by
+    // finalize(collision_out)
+    bool collision_detected() const { return collision; }
+
+private:
+    // compresses block into H_out, returning true if collision detection is on and flagged it
+    bool process(sha1_state& H_out, const uint8_t* block) const;
+
+    sha1_state H = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+    std::array<uint8_t, 64> buffer = {};
+    sha1_len msg_len = 0;
+
+    bool check = false;
+    bool safe = true;
+    bool collision = false;
+};
+
 // preprocesses a string into array of words with padding
 // input str must have num_bits < 2^64 otherwise this function will not work properly
 // returns a vector containing words
@@ -145,7 +243,7 @@ std::vector<sha1_word> sha1::preprocess_str(const std::string& str)
 }
 
 // logical function, taking t parameter 0 <= t < 80
-sha1_word sha1::f(const sha1_word& t, const sha1_word& B, const sha1_word& C, const sha1_word& D)
+constexpr sha1_word sha1::f(const sha1_word& t, const sha1_word& B, const sha1_word& C, const sha1_word& D)
 {
     assert(t >= 0 && t < 80);
 
@@ -163,7 +261,7 @@ sha1_word sha1::f(const sha1_word& t, const sha1_word& B, const sha1_word& C, co
 }
 
 // constant function, taking t parameter 0 <= t < 80
-sha1_word sha1::K(const sha1_word& t)
+constexpr sha1_word sha1::K(const sha1_word& t)
 {
     assert(t >= 0 && t < 80);
 
@@ -183,91 +281,618 @@ sha1_word sha1::K(const sha1_word& t)
         return 0;
 }
 
-// computes message digest using sha1 algorithm
-std::string sha1::digest(const std::string& str)
+// expands one 512-bit block into the word sequence used by the 80 steps
+constexpr std::array<sha1_word, 80> sha1::expand(const uint8_t* block)
 {
-    // ensures that string is properly padded
-    std::vector<sha1_word> word_vec = sha1::preprocess_str(str);
+    // create word sequence
+    std::array<sha1_word, 80> word_seq = {};
+
+    // assign word_seq[0] - word_seq[15] as the big-endian words in the block
+    for (int j = 0; j < 16; ++j)
+    {
+        word_seq[j] = ((sha1_word)block[4*j] << 24) | ((sha1_word)block[4*j + 1] << 16)
+                    | ((sha1_word)block[4*j + 2] << 8) | (sha1_word)block[4*j + 3];
+    }
 
-    // compute number of blocks provided
-    // each block contains block_size / (sizeof(word) * 8) number of words
-    uint32_t num_blocks = word_vec.size() / (sha1_block_size / (sizeof(sha1_word) * 8));
+    // assign remaining words in word_seq according to formula
+    for (int j = 16; j < 80; ++j)
+    {
+        word_seq[j] = circ_left_shift(word_seq[j - 3] ^ word_seq[j - 8] ^ word_seq[j - 14] ^ word_seq[j - 16], 1);
+    }
 
-    // create buffer variables
-    sha1_word  A,  B,  C,  D,  E;
-    sha1_word H0, H1, H2, H3, H4;
+    return word_seq;
+}
+
+// V holds the buffer variables A, B, C, D, E
+constexpr void sha1::steps(sha1_state& V, const std::array<sha1_word, 80>& word_seq, int first, int last)
+{
+    sha1_word A = V[0], B = V[1], C = V[2], D = V[3], E = V[4];
 
     // temp buffer
-    sha1_word temp;
+    sha1_word temp = 0;
 
-    // create word sequence
-    std::array<sha1_word, 80> word_seq;
+    for (int j = first; j < last; ++j)
+    {
+        temp = circ_left_shift(A, 5) + f(j, B, C, D) + E + word_seq[j] + K(j);
+
+        E = D;
+        D = C;
+        C = circ_right_shift(B, 2);
+        B = A;
+        A = temp;
+    }
 
-    // before processing blocks, initialise H0, H1, H2, H3, H4 in buffer2
-    H0 = 0x67452301;
-    H1 = 0xefcdab89;
-    H2 = 0x98badcfe;
-    H3 = 0x10325476;
-    H4 = 0xc3d2e1f0;
+    V = {A, B, C, D, E};
+}
+
+// each step only shifts A, B, C, D into B, C, D, E and computes a new A, so it can be run backwards
+// by recovering the old E from the new A
+constexpr void sha1::unsteps(sha1_state& V, const std::array<sha1_word, 80>& word_seq, int first, int last)
+{
+    sha1_word A = V[0], B = V[1], C = V[2], D = V[3], E = V[4];
 
-    // iterate through each 512-bit word block
-    for (int i = 0; i < num_blocks; ++i)
+    for (int j = last - 1; j >= first; --j)
     {
-        // assign word_seq[0] - word_seq[15] as words in word block
-        for (int j = 0; j < 16; ++j)
-        {
-            word_seq[j] = word_vec[i*16 + j];
-        }
+        sha1_word prev_A = B;
+        sha1_word prev_B = circ_left_shift(C, 2);
+        sha1_word prev_C = D;
+        sha1_word prev_D = E;
+        sha1_word prev_E = A - circ_left_shift(prev_A, 5) - f(j, prev_B, prev_C, prev_D) - word_seq[j] - K(j);
+
+        A = prev_A;
+        B = prev_B;
+        C = prev_C;
+        D = prev_D;
+        E = prev_E;
+    }
+
+    V = {A, B, C, D, E};
+}
+
+// compresses one 512-bit block into the hash state H0, H1, H2, H3, H4
+constexpr void sha1::compress(sha1_state& H, const uint8_t* block)
+{
+    std::array<sha1_word, 80> word_seq = expand(block);
+
+    // initialise A, B, C, D, E in buffer1 to be H0, H1, H2, H3, H4 in buffer2
+    sha1_state V = H;
+
+    // main loop
+    steps(V, word_seq, 0, 80);
+
+    // unsigned addition wraps modulo 2^32, which is what SHA-1 requires
+    for (int i = 0; i < 5; ++i)
+        H[i] = H[i] + V[i];
+}
+
+// computes message digest using sha1 algorithm
+// full blocks are read straight from the input and only the final block(s) are padded,
+// following the same padding rule as preprocess_str
+constexpr sha1_digest sha1::hash(std::string_view str)
+{
+    // before processing blocks, initialise H0, H1, H2, H3, H4
+    sha1_state H = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+
+    sha1_len num_str_chars = str.size();
+    sha1_len num_full_blocks = num_str_chars / 64;
+
+    // iterate through each full 512-bit block
+    std::array<uint8_t, 64> block = {};
+    for (sha1_len i = 0; i < num_full_blocks; ++i)
+    {
+        for (int j = 0; j < 64; ++j)
+            block[j] = (uint8_t)str[64*i + j];
+        compress(H, block.data());
+    }
+
+    // the remaining chars, the binary 1 and the 64-bit length fill one or two more blocks
+    std::array<uint8_t, 128> tail = {};
+    sha1_len num_tail_chars = num_str_chars % 64;
+    for (sha1_len j = 0; j < num_tail_chars; ++j)
+        tail[j] = (uint8_t)str[64*num_full_blocks + j];
+    tail[num_tail_chars] = 0b10000000;
 
-        // assign remaining words in word_seq according to formula
-        for (int j = 16; j < 80; ++j)
+    sha1_len num_tail_blocks = (num_tail_chars + 1 + sizeof(sha1_len) <= 64) ? 1 : 2;
+    sha1_len num_str_bits = num_str_chars * 8;
+    for (int j = 0; j < 8; ++j)
+        tail[64*num_tail_blocks - 1 - j] = (uint8_t)(num_str_bits >> (8*j));
+
+    for (sha1_len i = 0; i < num_tail_blocks; ++i)
+        compress(H, tail.data() + 64*i);
+
+    return to_digest(H);
+}
+
+// output H0 .. H4 as big-endian bytes
+constexpr sha1_digest sha1::to_digest(const sha1_state& H)
+{
+    sha1_digest digest = {};
+    for (int i = 0; i < 5; ++i)
+        for (int j = 0; j < 4; ++j)
+            digest[4*i + j] = (uint8_t)(H[i] >> (24 - 8*j));
+
+    return digest;
+}
+
+// computes message digest as hexcode string
+std::string sha1::digest(const std::string& str)
+{
+    return bytes_to_hexcode(hash(str));
+}
+
+std::vector<sha1_digest> sha1::hash_batch(const std::vector<std::string>& strs)
+{
+    std::vector<sha1_digest> out(strs.size());
+
+#ifdef GV_X86_DISPATCH
+    if (cpu().avx2)
+    {
+        auto pad = [](const uint8_t* tail, size_t tail_len, uint64_t msg_len) { return md_pad(tail, tail_len, msg_len, 64, 8); };
+
+        for (size_t first = 0; first < strs.size(); first += sha1_lanes)
         {
-            word_seq[j] = circ_left_shift(word_seq[j - 3] ^ word_seq[j - 8] ^ word_seq[j - 14] ^ word_seq[j - 16], 1);
+            uint32_t num_lanes = (strs.size() - first < sha1_lanes) ? strs.size() - first : sha1_lanes;
+            lane_schedule<sha1_lanes, 64> schedule(&strs[first], num_lanes, pad);
+
+            alignas(32) sha1_word state[5][8];
+            const sha1_state H0 = {0x67452301, 0xefcdab89, 0x98badcfe, 0x10325476, 0xc3d2e1f0};
+            for (int w = 0; w < 5; ++w)
+                for (uint32_t l = 0; l < sha1_lanes; ++l)
+                    state[w][l] = H0[w];
+
+            for (size_t b = 0; b < schedule.num_blocks(); ++b)
+            {
+                const uint8_t* blocks[8];
+                uint32_t active = schedule.blocks(b, blocks);
+                compress_avx2_x8(state, blocks, active);
+            }
+
+            for (uint32_t l = 0; l < num_lanes; ++l)
+            {
+                sha1_state H = {state[0][l], state[1][l], state[2][l], state[3][l], state[4][l]};
+                out[first + l] = to_digest(H);
+            }
         }
+        return out;
+    }
+#endif
+
+    for (size_t i = 0; i < strs.size(); ++i)
+        out[i] = hash(strs[i]);
+    return out;
+}
+
+std::vector<std::string> sha1::digest_batch(const std::vector<std::string>& strs)
+{
+    std::vector<sha1_digest> digests = hash_batch(strs);
+    std::vector<std::string> hexcodes(digests.size());
+    for (size_t i = 0; i < digests.size(); ++i)
+        hexcodes[i] = bytes_to_hexcode(digests[i]);
+    return hexcodes;
+}
+
+void sha1::context::update(const uint8_t* data, size_t len)
+{
+    size_t buffered = msg_len % 64;
+    msg_len += len;
+
+    // top up a partial block first
+    if (buffered > 0)
+    {
+        size_t take = (len < 64 - buffered) ? len : 64 - buffered;
+        std::memcpy(buffer.data() + buffered, data, take);
+        data += take;
+        len -= take;
+        if (buffered + take < 64)
+            return;
+        collision = process(H, buffer.data()) || collision;
+    }
 
-        // initialise A, B, C, D, E in buffer1 to be H0, H1, H2, H3, H4 in buffer2
-        A = H0;
-        B = H1;
-        C = H2;
-        D = H3;
-        E = H4;
+    for (; len >= 64; data += 64, len -= 64)
+        collision = process(H, data) || collision;
+
+    std::memcpy(buffer.data(), data, len);
+}
+
+sha1_digest sha1::context::finalize() const
+{
+    bool tail_collision;
+    return finalize(tail_collision);
+}
+
+sha1_digest sha1::context::finalize(bool& collision_out) const
+{
+    collision_out = collision;
+
+    sha1_state H_final = H;
+    std::vector<uint8_t> tail = md_pad(buffer.data(), msg_len % 64, msg_len, 64, 8);
+    for (size_t i = 0; i < tail.size(); i += 64)
+        collision_out = process(H_final, tail.data() + i) || collision_out;
+    return to_digest(H_final);
+}
+
+bool sha1::context::process(sha1_state& H_out, const uint8_t* block) const
+{
+    if (check)
+        return compress_checked(H_out, block, safe);
 
-        // main loop
+    compress(H_out, block);
+    return false;
+}
+
+std::string sha1::context::export_state() const
+{
+    return export_midstate(midstate_algorithm::sha1, msg_len, H, buffer.data(), 64);
+}
+
+sha1::context sha1::context::import_state(const std::string& data)
+{
+    context ctx;
+    import_midstate(data, midstate_algorithm::sha1, ctx.msg_len, ctx.H, ctx.buffer.data(), 64);
+    return ctx;
+}
+
+// **************************************************************************************************************
+// SHA-1 COLLISION DETECTION
+// **************************************************************************************************************
+
+// the known collision attacks on SHA-1 (including SHAttered) follow a disturbance vector DV[0..79], a sequence
+// satisfying the message expansion recurrence where every set bit starts a local collision: a difference put
+// into A at step t by W[t] and cancelled by the message differences at steps t+1 .. t+5
+// the 32 vectors below are the type I and II vectors checked by sha1dc (Manuel's classification), generated
+// from the 16-word windows that define them
+//   I(K,b):  DV[K .. K+14] = 0, DV[K+15] = 2^b
+//   II(K,b): DV[K .. K+15] = 0 except DV[K+1] = DV[K+3] = 2^(b+31), DV[K+15] = 2^b
+// after the last correction before the window the two messages of a collision share the same working state
+// (steps K+5 .. K+15 for type I, K+8 .. K+15 for type II), so steps 58 and 65 between them cover every vector
+
+struct sha1_disturbance_vector
+{
+    uint8_t type;
+    uint8_t K;
+    uint8_t b;
+    uint8_t test_step;              // both messages have the same working state before this step
+    std::array<sha1_word, 80> dm;   // message xor difference
+};
+
+// DV[t] for -5 <= t < 80, stored at index t + 5
+constexpr std::array<sha1_word, 85> sha1_dv_sequence(int type, int K, int b)
+{
+    std::array<sha1_word, 85> V = {};
+
+    V[5 + K + 15] = (sha1_word)1 << b;
+    if (type == 2)
+        V[5 + K + 1] = V[5 + K + 3] = circ_right_shift((sha1_word)1 << b, 1);
+
+    // the recurrence runs forwards from the window, and backwards as W[t] = ror(W[t+16], 1) ^ W[t+13] ^ W[t+8] ^ W[t+2]
+    for (int t = K + 16; t < 80; ++t)
+        V[5 + t] = circ_left_shift(V[5 + t - 3] ^ V[5 + t - 8] ^ V[5 + t - 14] ^ V[5 + t - 16], 1);
+    for (int t = K - 1; t >= -5; --t)
+        V[5 + t] = circ_right_shift(V[5 + t + 16], 1) ^ V[5 + t + 13] ^ V[5 + t + 8] ^ V[5 + t + 2];
+
+    return V;
+}
+
+// the differences W[t] has to cancel: the disturbance started at step t, then the corrections for the
+// disturbances from steps t-1 .. t-5 as they pass through rol(A, 5), f (B, C, D) and E
+constexpr std::array<sha1_word, 6> sha1_dv_terms(const std::array<sha1_word, 85>& V, int t)
+{
+    return {V[5 + t], circ_left_shift(V[5 + t - 1], 5), V[5 + t - 2], circ_left_shift(V[5 + t - 3], 30),
+            circ_left_shift(V[5 + t - 4], 30), circ_left_shift(V[5 + t - 5], 30)};
+}
+
+constexpr sha1_disturbance_vector make_disturbance_vector(int type, int K, int b)
+{
+    sha1_disturbance_vector dv = {(uint8_t)type, (uint8_t)K, (uint8_t)b, (uint8_t)(K < 50 ? 58 : 65), {}};
+
+    std::array<sha1_word, 85> V = sha1_dv_sequence(type, K, b);
+    for (int t = 0; t < 80; ++t)
+    {
+        std::array<sha1_word, 6> terms = sha1_dv_terms(V, t);
+        dv.dm[t] = terms[0] ^ terms[1] ^ terms[2] ^ terms[3] ^ terms[4] ^ terms[5];
+    }
+    return dv;
+}
+
+constexpr std::array<sha1_disturbance_vector, 32> sha1_disturbance_vectors = {
+    make_disturbance_vector(1, 43, 0), make_disturbance_vector(1, 44, 0), make_disturbance_vector(1, 45, 0),
+    make_disturbance_vector(1, 46, 0), make_disturbance_vector(1, 46, 2), make_disturbance_vector(1, 47, 0),
+    make_disturbance_vector(1, 47, 2), make_disturbance_vector(1, 48, 0), make_disturbance_vector(1, 48, 2),
+    make_disturbance_vector(1, 49, 0), make_disturbance_vector(1, 49, 2), make_disturbance_vector(1, 50, 0),
+    make_disturbance_vector(1, 50, 2), make_disturbance_vector(1, 51, 0), make_disturbance_vector(1, 51, 2),
+    make_disturbance_vector(1, 52, 0),
+    make_disturbance_vector(2, 45, 0), make_disturbance_vector(2, 46, 0), make_disturbance_vector(2, 46, 2),
+    make_disturbance_vector(2, 47, 0), make_disturbance_vector(2, 48, 0), make_disturbance_vector(2, 49, 0),
+    make_disturbance_vector(2, 49, 2), make_disturbance_vector(2, 50, 0), make_disturbance_vector(2, 50, 2),
+    make_disturbance_vector(2, 51, 0), make_disturbance_vector(2, 51, 2), make_disturbance_vector(2, 52, 0),
+    make_disturbance_vector(2, 53, 0), make_disturbance_vector(2, 54, 0), make_disturbance_vector(2, 55, 0),
+    make_disturbance_vector(2, 56, 0)};
+
+// sha1dc's published message differences for a few of the vectors, every one of the 80 words must match
+constexpr bool sha1_dv_matches(const sha1_disturbance_vector& dv, const std::array<sha1_word, 80>& dm)
+{
+    for (int t = 0; t < 80; ++t)
+        if (dv.dm[t] != dm[t])
+            return false;
+    return true;
+}
+
+static_assert(sha1_dv_matches(sha1_disturbance_vectors[0], {
+    0x08000000, 0x9800000c, 0xd8000010, 0x08000010, 0xb8000010, 0x98000000, 0x60000000, 0x00000008,
+    0xc0000000, 0x90000014, 0x10000010, 0xb8000014, 0x28000000, 0x20000010, 0x48000000, 0x08000018,
+    0x60000000, 0x90000010, 0xf0000010, 0x90000008, 0xc0000000, 0x90000010, 0xf0000010, 0xb0000008,
+    0x40000000, 0x90000000, 0xf0000010, 0x90000018, 0x60000000, 0x90000010, 0x90000010, 0x90000000,
+    0x80000000, 0x00000010, 0xa0000000, 0x20000000, 0xa0000000, 0x20000010, 0x00000000, 0x20000010,
+    0x20000000, 0x00000010, 0x20000000, 0x00000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000040, 0x40000002,
+    0x80000004, 0x80000080, 0x80000006, 0x00000049, 0x00000103, 0x80000009, 0x80000012, 0x80000202,
+    0x00000018, 0x00000164, 0x00000408, 0x800000e6, 0x8000004c, 0x00000803, 0x80000161, 0x80000599}),
+              "disturbance vector I(43,0) has the wrong message difference");
+
+static_assert(sha1_dv_matches(sha1_disturbance_vectors[8], {
+    0xe000002a, 0x20000043, 0xb0000040, 0xd0000053, 0xd0000022, 0x20000000, 0x60000032, 0x60000043,
+    0x20000040, 0xe0000042, 0x60000002, 0x80000001, 0x00000020, 0x00000003, 0x40000052, 0x40000040,
+    0xe0000052, 0xa0000000, 0x80000040, 0x20000001, 0x20000060, 0x80000001, 0x40000042, 0xc0000043,
+    0x40000022, 0x00000003, 0x40000042, 0xc0000043, 0xc0000022, 0x00000001, 0x40000002, 0xc0000043,
+    0x40000062, 0x80000001, 0x40000042, 0x40000042, 0x40000002, 0x00000002, 0x00000040, 0x80000002,
+    0x80000000, 0x80000002, 0x80000040, 0x00000000, 0x80000040, 0x80000000, 0x00000040, 0x80000000,
+    0x00000040, 0x80000002, 0x00000000, 0x80000000, 0x80000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000004,
+    0x00000080, 0x00000004, 0x00000009, 0x00000101, 0x00000009, 0x00000012, 0x00000202, 0x0000001a,
+    0x00000124, 0x0000040c, 0x00000026, 0x0000004a, 0x0000080a, 0x00000060, 0x00000590, 0x00001020}),
+              "disturbance vector I(48,2) has the wrong message difference");
+
+static_assert(sha1_dv_matches(sha1_disturbance_vectors[27], {
+    0x0c000002, 0xc0000010, 0xb400001c, 0x3c000004, 0xbc00001a, 0x20000010, 0x2400001c, 0xec000014,
+    0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004, 0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010,
+    0x08000018, 0x78000010, 0x08000014, 0x70000010, 0xb800001c, 0xe8000000, 0xb0000004, 0x58000010,
+    0xb000000c, 0x48000000, 0xb0000000, 0xb8000010, 0x98000010, 0xa0000000, 0x00000000, 0x00000000,
+    0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0x20000000, 0x00000010, 0x60000000,
+    0x00000018, 0xe0000000, 0x90000000, 0x30000010, 0xb0000000, 0x20000000, 0x20000000, 0xa0000000,
+    0x00000010, 0x80000000, 0x20000000, 0x20000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+    0x20000010, 0xa0000000, 0x00000000, 0x20000000, 0x20000000, 0x00000000, 0x00000000, 0x00000000,
+    0x00000000, 0x00000000, 0x00000000, 0x00000001, 0x00000020, 0x00000001, 0x40000002, 0x40000041,
+    0x40000022, 0x80000005, 0xc0000082, 0xc0000046, 0x4000004b, 0x80000107, 0x00000089, 0x00000014}),
+              "disturbance vector II(52,0) has the wrong message difference");
+
+static_assert(sha1_dv_matches(sha1_disturbance_vectors[31], {
+    0x2600001a, 0x00000010, 0x0400001c, 0xcc000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x3c000004,
+    0xbc00001a, 0x20000010, 0x2400001c, 0xec000014, 0x0c000002, 0xc0000010, 0xb400001c, 0x2c000004,
+    0xbc000018, 0xb0000010, 0x0000000c, 0xb8000010, 0x08000018, 0x78000010, 0x08000014, 0x70000010,
+    0xb800001c, 0xe8000000, 0xb0000004, 0x58000010, 0xb000000c, 0x48000000, 0xb0000000, 0xb8000010,
+    0x98000010, 0xa0000000, 0x00000000, 0x00000000, 0x20000000, 0x80000000, 0x00000010, 0x00000000,
+    0x20000010, 0x20000000, 0x00000010, 0x60000000, 0x00000018, 0xe0000000, 0x90000000, 0x30000010,
+    0xb0000000, 0x20000000, 0x20000000, 0xa0000000, 0x00000010, 0x80000000, 0x20000000, 0x20000000,
+    0x20000000, 0x80000000, 0x00000010, 0x00000000, 0x20000010, 0xa0000000, 0x00000000, 0x20000000,
+    0x20000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000000, 0x00000001,
+    0x00000020, 0x00000001, 0x40000002, 0x40000041, 0x40000022, 0x80000005, 0xc0000082, 0xc0000046}),
+              "disturbance vector II(56,0) has the wrong message difference");
+
+// cheap filter run on every block before any recomputation: the unavoidable bit conditions of sha1dc's
+// ubc_check, i.e. the conditions on the expanded message that every attack path along a vector has to
+// satisfy, each one a pair of bits of W[35 .. 64] that must be equal or differ
+// a block failing any condition of a vector cannot be half of a collision along that vector, so the table is
+// exactly sha1dc's filter (checked block for block against its ubc_check) and never drops a genuine trail
+struct sha1_dv_condition
+{
+    uint8_t i, a;       // bit a of W[i]
+    uint8_t j, b;       // xor bit b of W[j]
+    uint8_t value;
+    uint32_t dvs;       // the vectors ruled out when the condition fails, bit k for sha1_disturbance_vectors[k]
+};
+
+constexpr std::array<sha1_dv_condition, 214> sha1_dv_conditions = {{
+    {35, 1, 36, 6, 1, 0x00000410}, {35, 3, 39, 28, 0, 0x00082000}, {35, 4, 39, 29, 0, 0x00080084},
+    {35, 5, 39, 30, 0, 0x00004000}, {35, 30, 36, 3, 1, 0x00100000}, {36, 0, 37, 5, 1, 0x00400000},
+    {36, 1, 37, 6, 1, 0x00041040}, {36, 3, 40, 28, 0, 0x00100000}, {36, 4, 37, 4, 1, 0x00000800},
+    {36, 4, 38, 4, 1, 0x28000000}, {36, 4, 40, 29, 0, 0x00110208}, {36, 30, 37, 3, 1, 0x00200000},
+    {37, 0, 38, 5, 1, 0x01000000}, {37, 1, 37, 6, 0, 0x00004000}, {37, 1, 38, 6, 1, 0x00000100},
+    {37, 3, 41, 28, 0, 0x00200000}, {37, 4, 38, 4, 1, 0x00002000}, {37, 4, 39, 4, 1, 0x50000001},
+    {37, 4, 40, 29, 0, 0x00020020}, {37, 4, 41, 29, 0, 0x00200800}, {37, 5, 41, 30, 0, 0x00400000},
+    {37, 6, 38, 6, 1, 0x00004000}, {37, 30, 38, 3, 1, 0x00800000}, {38, 0, 39, 5, 1, 0x04000000},
+    {38, 1, 39, 6, 1, 0x00000400}, {38, 3, 42, 28, 0, 0x00800000}, {38, 4, 39, 4, 1, 0x00008000},
+    {38, 4, 40, 4, 1, 0xa0000002}, {38, 4, 40, 29, 0, 0x00080080}, {38, 4, 42, 29, 0, 0x00802000},
+    {38, 5, 42, 30, 0, 0x01000000}, {38, 30, 39, 3, 1, 0x02000000}, {39, 1, 40, 6, 1, 0x00401010},
+    {39, 3, 43, 28, 0, 0x02000000}, {39, 4, 40, 29, 1, 0x50000001}, {39, 4, 41, 4, 1, 0x00000004},
+    {39, 4, 41, 29, 0, 0x00100200}, {39, 4, 43, 29, 0, 0x02008000}, {39, 5, 43, 30, 0, 0x04000000},
+    {39, 6, 40, 1, 0, 0x00000400}, {39, 30, 40, 3, 1, 0x08000000}, {40, 1, 41, 6, 1, 0x01004040},
+    {40, 3, 44, 28, 0, 0x08000000}, {40, 4, 40, 29, 1, 0x80000002}, {40, 4, 41, 29, 1, 0x20000000},
+    {40, 4, 42, 4, 1, 0x00000008}, {40, 4, 42, 29, 0, 0x00200800}, {40, 4, 44, 29, 0, 0x08000000},
+    {40, 6, 41, 1, 0, 0x00401000}, {40, 6, 42, 6, 0, 0x00000010}, {40, 29, 41, 4, 0, 0x40000001},
+    {40, 29, 41, 29, 0, 0x800a00a2}, {41, 1, 42, 6, 1, 0x04040100}, {41, 3, 45, 28, 0, 0x10000000},
+    {41, 4, 41, 29, 1, 0x00000004}, {41, 4, 42, 29, 1, 0x40000001}, {41, 4, 43, 4, 1, 0x00000020},
+    {41, 4, 43, 29, 0, 0x00812000}, {41, 4, 45, 29, 0, 0x10000000}, {41, 6, 42, 1, 0, 0x01004000},
+    {41, 6, 43, 6, 0, 0x00000040}, {41, 29, 42, 4, 0, 0x80000002}, {41, 29, 42, 29, 0, 0x00180284},
+    {42, 1, 43, 6, 1, 0x00000400}, {42, 3, 46, 28, 0, 0x20000000}, {42, 4, 42, 29, 1, 0x00000008},
+    {42, 4, 43, 29, 1, 0x80000002}, {42, 4, 44, 4, 1, 0x00000080}, {42, 4, 44, 29, 0, 0x02028000},
+    {42, 4, 46, 29, 0, 0x20000000}, {42, 6, 43, 1, 0, 0x04040000}, {42, 6, 44, 6, 0, 0x00000110},
+    {42, 29, 43, 4, 0, 0x00000005}, {42, 29, 43, 29, 0, 0x00300a08}, {43, 1, 44, 6, 1, 0x00001000},
+    {43, 3, 47, 28, 0, 0x40000000}, {43, 4, 43, 29, 1, 0x00000020}, {43, 4, 44, 29, 1, 0x00000005},
+    {43, 4, 45, 4, 1, 0x00000200}, {43, 4, 45, 29, 0, 0x08080000}, {43, 4, 47, 29, 0, 0x40000000},
+    {43, 6, 45, 6, 0, 0x00000440}, {43, 29, 44, 4, 0, 0x0000000a}, {43, 29, 44, 29, 0, 0x00a12820},
+    {44, 1, 45, 6, 1, 0x00404000}, {44, 3, 48, 28, 0, 0x80000000}, {44, 4, 44, 29, 1, 0x00000080},
+    {44, 4, 45, 29, 1, 0x0000000a}, {44, 4, 46, 4, 1, 0x00000800}, {44, 4, 46, 29, 0, 0x10100000},
+    {44, 4, 48, 29, 0, 0x80000000}, {44, 6, 46, 6, 0, 0x00001110}, {44, 29, 45, 4, 0, 0x00000024},
+    {44, 29, 45, 29, 0, 0x0283a080}, {44, 29, 46, 29, 1, 0x00000001}, {45, 1, 46, 6, 1, 0x01000000},
+    {45, 4, 45, 29, 1, 0x00000200}, {45, 4, 46, 29, 1, 0x00000024}, {45, 4, 47, 4, 1, 0x00002000},
+    {45, 4, 47, 29, 0, 0x20200000}, {45, 6, 46, 1, 0, 0x00400000}, {45, 6, 47, 6, 0, 0x00004440},
+    {45, 29, 46, 4, 0, 0x00000088}, {45, 29, 46, 29, 0, 0x0a0a8200}, {45, 29, 47, 29, 1, 0x00000002},
+    {46, 1, 47, 6, 1, 0x04000000}, {46, 4, 46, 29, 1, 0x00000800}, {46, 4, 47, 29, 1, 0x00000088},
+    {46, 4, 48, 4, 1, 0x00008000}, {46, 4, 48, 29, 0, 0x40800000}, {46, 6, 47, 1, 0, 0x01000010},
+    {46, 6, 48, 6, 0, 0x00001100}, {46, 29, 47, 4, 0, 0x00000220}, {46, 29, 47, 29, 0, 0x18180801},
+    {46, 29, 48, 29, 1, 0x00000004}, {47, 1, 48, 6, 1, 0x00040000}, {47, 4, 47, 29, 1, 0x00002000},
+    {47, 4, 48, 29, 1, 0x00000220}, {47, 4, 49, 4, 1, 0x00010000}, {47, 4, 49, 29, 0, 0x82000000},
+    {47, 6, 48, 1, 0, 0x04000040}, {47, 6, 49, 6, 0, 0x00004400}, {47, 29, 48, 4, 0, 0x00000880},
+    {47, 29, 48, 29, 0, 0x30302002}, {47, 29, 49, 29, 1, 0x00000008}, {48, 4, 48, 29, 1, 0x00008000},
+    {48, 4, 49, 29, 1, 0x00000880}, {48, 4, 50, 4, 1, 0x00020000}, {48, 4, 50, 29, 0, 0x08000000},
+    {48, 6, 49, 1, 0, 0x00000100}, {48, 6, 50, 6, 0, 0x00041000}, {48, 29, 49, 4, 0, 0x00002200},
+    {48, 29, 49, 29, 0, 0x60a08004}, {48, 29, 50, 29, 1, 0x00000020}, {49, 4, 49, 29, 1, 0x00010000},
+    {49, 4, 50, 29, 1, 0x00002200}, {49, 4, 51, 4, 1, 0x00080000}, {49, 4, 51, 29, 0, 0x10000000},
+    {49, 6, 50, 1, 0, 0x00000400}, {49, 6, 51, 6, 0, 0x00004000}, {49, 29, 50, 4, 0, 0x00008800},
+    {49, 29, 50, 29, 0, 0xc2810008}, {49, 29, 51, 29, 1, 0x00000080}, {50, 1, 51, 6, 1, 0x00400000},
+    {50, 4, 50, 29, 1, 0x00020000}, {50, 4, 51, 29, 1, 0x00008800}, {50, 4, 52, 4, 1, 0x00100000},
+    {50, 4, 52, 29, 0, 0x20000000}, {50, 6, 51, 1, 0, 0x00041000}, {50, 29, 51, 4, 0, 0x00002000},
+    {50, 29, 51, 29, 0, 0x8a020020}, {50, 29, 52, 29, 1, 0x00010200}, {51, 1, 52, 6, 1, 0x01000000},
+    {51, 4, 51, 29, 1, 0x00080000}, {51, 4, 52, 29, 1, 0x00002000}, {51, 4, 53, 4, 1, 0x00200000},
+    {51, 4, 53, 29, 0, 0x40000000}, {51, 6, 52, 1, 0, 0x00004000}, {51, 6, 53, 6, 0, 0x00400000},
+    {51, 29, 52, 4, 0, 0x00008000}, {51, 29, 52, 29, 0, 0x18080080}, {51, 29, 53, 29, 1, 0x00020800},
+    {52, 1, 53, 6, 1, 0x04000000}, {52, 4, 52, 29, 1, 0x00100000}, {52, 4, 53, 29, 1, 0x00008000},
+    {52, 4, 54, 4, 1, 0x00800000}, {52, 4, 54, 29, 0, 0x80000000}, {52, 6, 54, 6, 0, 0x01000000},
+    {52, 29, 53, 29, 0, 0x30110200}, {52, 29, 54, 29, 1, 0x00082000}, {53, 4, 53, 29, 1, 0x00200000},
+    {53, 4, 55, 4, 1, 0x02000000}, {53, 6, 54, 1, 0, 0x00400000}, {53, 6, 55, 6, 0, 0x04000000},
+    {53, 29, 54, 29, 0, 0x60220800}, {53, 29, 55, 29, 1, 0x00108000}, {54, 4, 54, 29, 1, 0x00800000},
+    {54, 4, 56, 4, 1, 0x08000000}, {54, 6, 55, 1, 0, 0x01000000}, {54, 29, 55, 29, 0, 0xc0882000},
+    {54, 29, 56, 29, 1, 0x00200000}, {55, 4, 55, 29, 1, 0x02000000}, {55, 4, 57, 4, 1, 0x10000000},
+    {55, 6, 56, 1, 0, 0x04000000}, {55, 29, 56, 29, 0, 0x82108000}, {55, 29, 57, 29, 1, 0x00800000},
+    {56, 4, 56, 29, 1, 0x08000000}, {56, 4, 58, 29, 0, 0x20000000}, {56, 29, 57, 29, 0, 0x08200000},
+    {56, 29, 58, 29, 1, 0x02000000}, {57, 4, 57, 29, 1, 0x10000000}, {57, 4, 59, 29, 0, 0x40000000},
+    {57, 29, 58, 29, 0, 0x10800000}, {57, 29, 59, 29, 1, 0x08000000}, {58, 0, 59, 5, 1, 0x00000001},
+    {58, 4, 62, 29, 0, 0x20000000}, {58, 29, 59, 29, 0, 0x22000000}, {58, 29, 61, 29, 1, 0x10000000},
+    {59, 0, 60, 5, 1, 0x00000002}, {59, 4, 63, 29, 0, 0x40000000}, {59, 5, 63, 30, 0, 0x00000001},
+    {59, 29, 60, 29, 0, 0x08000000}, {60, 0, 61, 5, 1, 0x00010004}, {60, 4, 64, 29, 0, 0x80000000},
+    {60, 5, 64, 30, 0, 0x00000002}, {61, 0, 62, 5, 1, 0x00020008}, {61, 1, 62, 6, 1, 0x00000001},
+    {61, 2, 62, 7, 1, 0x00040010}, {62, 0, 63, 5, 1, 0x00080020}, {62, 1, 63, 6, 1, 0x00000002},
+    {62, 2, 63, 7, 1, 0x00000040}, {63, 0, 64, 5, 1, 0x00100080}, {63, 1, 64, 6, 1, 0x00010004},
+    {63, 2, 64, 7, 1, 0x00000100}
+}};
+
+// the conditions are unrolled so every index, bit and mask is an immediate
+template <size_t... I>
+uint32_t sha1_dv_candidates(const std::array<sha1_word, 80>& W, std::index_sequence<I...>)
+{
+    uint32_t mask = ~(uint32_t)0;
+    ((mask &= ~sha1_dv_conditions[I].dvs
+              | -(((W[sha1_dv_conditions[I].i] >> sha1_dv_conditions[I].a)
+                   ^ (W[sha1_dv_conditions[I].j] >> sha1_dv_conditions[I].b) ^ sha1_dv_conditions[I].value ^ 1) & 1)), ...);
+    return mask;
+}
+
+bool sha1::compress_checked(sha1_state& H, const uint8_t* block, bool safe_hash)
+{
+    std::array<sha1_word, 80> word_seq = expand(block);
+
+    // same as compress, keeping the working state at both test steps
+    sha1_state V = H;
+    steps(V, word_seq, 0, 58);
+    sha1_state V58 = V;
+    steps(V, word_seq, 58, 65);
+    sha1_state V65 = V;
+    steps(V, word_seq, 65, 80);
+
+    for (int i = 0; i < 5; ++i)
+        H[i] = H[i] + V[i];
+
+    uint32_t candidates = sha1_dv_candidates(word_seq, std::make_index_sequence<sha1_dv_conditions.size()>());
+
+    for (uint32_t i = 0; candidates != 0; ++i, candidates >>= 1)
+    {
+        if (!(candidates & 1))
+            continue;
+
+        const sha1_disturbance_vector& dv = sha1_disturbance_vectors[i];
+
+        std::array<sha1_word, 80> other_seq = {};
         for (int j = 0; j < 80; ++j)
+            other_seq[j] = word_seq[j] ^ dv.dm[j];
+
+        // starting from the shared working state, the other message runs backwards to its chaining value
+        // and forwards to its output, a collision if that output equals ours
+        sha1_state other_in = (dv.test_step == 58) ? V58 : V65;
+        sha1_state other_out = other_in;
+        unsteps(other_in, other_seq, 0, dv.test_step);
+        steps(other_out, other_seq, dv.test_step, 80);
+
+        bool same = true;
+        for (int k = 0; k < 5; ++k)
+            same = same && (sha1_word)(other_in[k] + other_out[k]) == H[k];
+
+        if (same)
         {
-            temp = circ_left_shift(A, 5) + f(j, B, C, D) + E + word_seq[j] + K(j);
-            
-            E = D;
-            D = C;
-            C = circ_right_shift(B, 2);
-            B = A;
-            A = temp;
+            if (safe_hash)
+            {
+                compress(H, block);
+                compress(H, block);
+            }
+            return true;
         }
-
-        // does this handle overflow and its undefined behaviour?
-        H0 = H0 + A;
-        H1 = H1 + B;
-        H2 = H2 + C;
-        H3 = H3 + D;
-        H4 = H4 + E;
     }
 
-    std::vector<sha1_word> words = {H0, H1, H2, H3, H4};
+    return false;
+}
+
+sha1_digest sha1::hash_checked(std::string_view str, bool& collision, bool safe_hash)
+{
+    context ctx;
+    ctx.detect_collisions(safe_hash);
+    ctx.update(str);
+
+    return ctx.finalize(collision);
+}
 
-    // use this string stream to build the output digest text
-    std::ostringstream oss;
+#ifdef GV_X86_DISPATCH
+
+#define GV_ROTL32_X8(x, n) _mm256_or_si256(_mm256_slli_epi32(x, n), _mm256_srli_epi32(x, 32 - (n)))
+
+// one SHA-1 step for 8 lanes, word_seq is kept as a rolling window of 16 words
+#define GV_SHA1_STEP_X8(j, f_expr, k) \
+    { \
+        if (j >= 16) \
+            W[j % 16] = GV_ROTL32_X8(_mm256_xor_si256(_mm256_xor_si256(W[(j - 3) % 16], W[(j - 8) % 16]), \
+                                                      _mm256_xor_si256(W[(j - 14) % 16], W[j % 16])), 1); \
+        __m256i temp = _mm256_add_epi32(_mm256_add_epi32(GV_ROTL32_X8(A, 5), f_expr), \
+                                        _mm256_add_epi32(_mm256_add_epi32(E, W[j % 16]), _mm256_set1_epi32(k))); \
+        E = D; \
+        D = C; \
+        C = GV_ROTL32_X8(B, 30); \
+        B = A; \
+        A = temp; \
+    }
 
-    // this pads a number shorter than the full width with zeros
-    // e.g. 1f becomes 0000001f
-    oss << std::hex << std::setfill('0');
+__attribute__((target("avx2")))
+void sha1::compress_avx2_x8(sha1_word state[5][8], const uint8_t* const blocks[8], uint32_t active)
+{
+    const __m256i bswap_mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
 
-    for (auto w : words)
+    __m256i W[16];
+    for (int half = 0; half < 2; ++half)
     {
-        // ensure 32-bit treated as unsigned to avoid sign extension issues
-        oss << std::setw(8) << (uint32_t)w;
+        __m256i r[8];
+        for (int l = 0; l < 8; ++l)
+            r[l] = _mm256_loadu_si256((const __m256i*)(blocks[l] + 32*half));
+        transpose_8x8_epi32(r);
+        for (int i = 0; i < 8; ++i)
+            W[8*half + i] = _mm256_shuffle_epi8(r[i], bswap_mask);
     }
 
-    return oss.str();
+    __m256i H[5];
+    for (int i = 0; i < 5; ++i)
+        H[i] = _mm256_load_si256((const __m256i*)state[i]);
+
+    __m256i A = H[0], B = H[1], C = H[2], D = H[3], E = H[4];
+
+    for (int j = 0; j < 20; ++j)
+        GV_SHA1_STEP_X8(j, _mm256_xor_si256(_mm256_and_si256(B, C), _mm256_andnot_si256(B, D)), 0x5a827999);
+    for (int j = 20; j < 40; ++j)
+        GV_SHA1_STEP_X8(j, _mm256_xor_si256(_mm256_xor_si256(B, C), D), 0x6ed9eba1);
+    for (int j = 40; j < 60; ++j)
+        GV_SHA1_STEP_X8(j, _mm256_or_si256(_mm256_and_si256(B, C), _mm256_and_si256(D, _mm256_or_si256(B, C))), (int)0x8f1bbcdc);
+    for (int j = 60; j < 80; ++j)
+        GV_SHA1_STEP_X8(j, _mm256_xor_si256(_mm256_xor_si256(B, C), D), (int)0xca62c1d6);
+
+    __m256i out[5] = {A, B, C, D, E};
+    __m256i mask = lane_mask_epi32(active);
+    for (int i = 0; i < 5; ++i)
+    {
+        __m256i updated = _mm256_add_epi32(H[i], out[i]);
+        _mm256_store_si256((__m256i*)state[i], _mm256_blendv_epi8(H[i], updated, mask));
+    }
 }
 
+#undef GV_SHA1_STEP_X8
+#undef GV_ROTL32_X8
+
+#endif
+
 } // namespace gv
\ No newline at end of file
@@ -1,12 +1,91 @@
 #include <iostream>
 #include "sha1.hpp"
 
+// the digest of a literal is a compile-time constant
+static_assert(gv::digest_word<uint32_t>(gv::sha1::hash("hello")) == 0xaaf4c61d, "SHA1 of hello should start with aaf4c61d");
+
+// the first 320 bytes of shattered-1.pdf (the PDF header and both near-collision blocks)
+const char* shattered_1_prefix =
+    "255044462d312e330a25e2e3cfd30a0a0a312030206f626a0a3c3c2f57696474682032203020522f4865696768742033"
+    "203020522f547970652034203020522f537562747970652035203020522f46696c7465722036203020522f436f6c6f72"
+    "53706163652037203020522f4c656e6774682038203020522f42697473506572436f6d706f6e656e7420383e3e0a7374"
+    "7265616d0affd8fffe00245348412d3120697320646561642121212121852fec092339759c39b1a1c63c4c97e1fffe01"
+    "7346dc9166b67e118f029ab621b2560ff9ca67cca8c7f85ba84c79030c2b3de218f86db3a90901d5df45c14f26fedfb3"
+    "dc38e96ac22fe7bd728f0e45bce046d23c570feb141398bb552ef5a0a82be331fea48037b8b5d71f0e332edf93ac3500"
+    "eb4ddc0decc1a864790c782c76215660dd309791d06bd0af3f98cda4bc4629b1";
+
 int main(int argc, char* argv[]) {
+    // shattered-2.pdf differs from shattered-1.pdf by the II(52,0) message difference in blocks 3 and 4
+    std::string shattered_1 = gv::hexcode_to_bytes(shattered_1_prefix);
+    std::string shattered_2 = shattered_1;
+    const gv::sha1_disturbance_vector& dv = gv::sha1_disturbance_vectors[27];
+    for (int block = 3; block < 5; ++block)
+        for (int i = 0; i < 64; ++i)
+            shattered_2[64*block + i] ^= (char)(dv.dm[i / 4] >> (24 - 8*(i % 4)));
+
+    std::cout << "SHAttered, plain:     " << gv::sha1::digest(shattered_1) << " " << gv::sha1::digest(shattered_2) << std::endl;
+    std::cout << "Should be:            f92d74e3874587aaf443d1db961d4e26dde13e9c (both)" << std::endl;
+
+    bool collision_1 = false, collision_2 = false;
+    std::string safe_1 = gv::bytes_to_hexcode(gv::sha1::hash_checked(shattered_1, collision_1));
+    std::string safe_2 = gv::bytes_to_hexcode(gv::sha1::hash_checked(shattered_2, collision_2));
+    std::cout << "SHAttered, safe hash: " << safe_1 << " " << safe_2 << " (detected " << collision_1 << collision_2 << ")" << std::endl;
+    std::cout << "Should be:            7117b3cb9225aaf0d8ef1a40e493957b0bf8693d 29f38ae9fd98e2931120fa0bf213e024250d3f6a (detected 11)" << std::endl;
+
+    // hash a message in two sessions, saving the midstate in between, for split points around the block edges
+    std::string message;
+    for (int i = 0; i < 200; ++i)
+        message.push_back((char)(i * 37));
+
+    bool resumed_ok = true;
+    for (size_t split : {0, 1, 63, 64, 65, 130, 199, 200}) {
+        gv::sha1::context first;
+        first.update(std::string_view(message).substr(0, split / 2));
+        first.update(std::string_view(message).substr(split / 2, split - split / 2));
+
+        gv::sha1::context second = gv::sha1::context::import_state(first.export_state());
+        second.update(std::string_view(message).substr(split));
+        resumed_ok = resumed_ok && second.length() == message.size() && second.finalize() == gv::sha1::hash(message);
+    }
+    std::cout << "Resumed from midstate: " << (resumed_ok ? "same digest" : "DIFFERENT digest") << " (should be same digest)" << std::endl;
+
+    // malformed midstates must be rejected: bad magic, version, algorithm and length
+    gv::sha1::context partial;
+    partial.update(message.substr(0, 100));
+    std::string state = partial.export_state();
+
+    int num_rejected = 0;
+    for (int field : {0, 4, 5, -1}) {
+        std::string bad = state;
+        if (field < 0)
+            bad.pop_back();
+        else
+            bad[field] ^= 0x7f;
+
+        try {
+            gv::sha1::context::import_state(bad);
+        }
+        catch (const std::invalid_argument&) {
+            ++num_rejected;
+        }
+    }
+    std::cout << "Malformed midstates rejected: " << num_rejected << " of 4" << std::endl;
+
     if (argc > 1) {
 
         std::string input(argv[1]);
 
         std::cout << input << " >>>> SHA1 >>>> " << gv::sha1::digest(input) << std::endl;
 
+        bool collision = false;
+        gv::sha1_digest checked = gv::sha1::hash_checked(input, collision);
+        std::cout << input << " >>>> SHA1 (collision detection) >>>> " << gv::bytes_to_hexcode(checked)
+                  << (collision ? " (collision attack detected)" : "") << std::endl;
+
     }
-}
\ No newline at end of file
+
+    bool ok = safe_1 == "7117b3cb9225aaf0d8ef1a40e493957b0bf8693d" && safe_2 == "29f38ae9fd98e2931120fa0bf213e024250d3f6a"
+              && collision_1 && collision_2 && gv::sha1::hash(shattered_1) == gv::sha1::hash(shattered_2)
+              && resumed_ok && num_rejected == 4;
+    return ok ? 0 : 1;
+}
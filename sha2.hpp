@@ -0,0 +1,925 @@
+/*
+SHA-2 (security hashing algorithm 2) functions/classes
+- SHA-224
+- SHA-256
+- SHA-384
+- SHA-512
+
+William Denny
+
+    - Follows https://doi.org/10.6028/NIST.FIPS.180-4
+
+    - The padding is the same as SHA-1: a single 1 bit, zeros, then the message length in bits
+      SHA-224/256 use 512-bit blocks and a 64-bit length, SHA-384/512 use 1024-bit blocks and a 128-bit length
+
+    - Backends:
+        portable    rounds unrolled 8 at a time so the working variables never have to be shuffled
+        SHA-NI      x86 SHA extensions (sha256rnds2, sha256msg1, sha256msg2), SHA-224/256 only
+        AVX2        multi-buffer, digest_batch hashes 8 messages (SHA-224/256) or 4 messages (SHA-384/512)
+                    at once, one message per vector lane
+
+*/
+
+#pragma once
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <array>
+#include <string_view>
+#include <assert.h>
+#include <cstring>
+
+#include "crypto_useful.hpp"
+
+namespace gv
+{
+
+// **************************************************************************************************************
+// SHA-2
+// **************************************************************************************************************
+
+// SHA-2 algorithm parameters/datatypes
+
+using sha256_word = uint32_t;
+
+using sha512_word = uint64_t;
+
+using sha256_state = std::array<sha256_word, 8>;
+
+using sha512_state = std::array<sha512_word, 8>;
+
+using sha224_digest = std::array<uint8_t, 28>;
+
+using sha256_digest = std::array<uint8_t, 32>;
+
+using sha384_digest = std::array<uint8_t, 48>;
+
+using sha512_digest = std::array<uint8_t, 64>;
+
+// the first N bytes of a hash value, each word big-endian
+template <size_t N, typename State>
+std::array<uint8_t, N> state_to_digest(const State& H)
+{
+    const size_t word_size = sizeof(typename State::value_type);
+
+    std::array<uint8_t, N> digest;
+    for (size_t i = 0; i < N; ++i)
+        digest[i] = (uint8_t)(H[i / word_size] >> (8 * (word_size - 1 - i % word_size)));
+    return digest;
+}
+
+// number of messages hashed together by the multi-buffer backends
+const uint32_t sha256_lanes = 8;
+
+const uint32_t sha512_lanes = 4;
+
+// round constants, the first 32/64 bits of the fractional parts of the cube roots of the first 64/80 primes
+const sha256_word sha256_K[64] = {
+    0x428a2f98, 0x71374491, 0xb5c0fbcf, 0xe9b5dba5, 0x3956c25b, 0x59f111f1, 0x923f82a4, 0xab1c5ed5,
+    0xd807aa98, 0x12835b01, 0x243185be, 0x550c7dc3, 0x72be5d74, 0x80deb1fe, 0x9bdc06a7, 0xc19bf174,
+    0xe49b69c1, 0xefbe4786, 0x0fc19dc6, 0x240ca1cc, 0x2de92c6f, 0x4a7484aa, 0x5cb0a9dc, 0x76f988da,
+    0x983e5152, 0xa831c66d, 0xb00327c8, 0xbf597fc7, 0xc6e00bf3, 0xd5a79147, 0x06ca6351, 0x14292967,
+    0x27b70a85, 0x2e1b2138, 0x4d2c6dfc, 0x53380d13, 0x650a7354, 0x766a0abb, 0x81c2c92e, 0x92722c85,
+    0xa2bfe8a1, 0xa81a664b, 0xc24b8b70, 0xc76c51a3, 0xd192e819, 0xd6990624, 0xf40e3585, 0x106aa070,
+    0x19a4c116, 0x1e376c08, 0x2748774c, 0x34b0bcb5, 0x391c0cb3, 0x4ed8aa4a, 0x5b9cca4f, 0x682e6ff3,
+    0x748f82ee, 0x78a5636f, 0x84c87814, 0x8cc70208, 0x90befffa, 0xa4506ceb, 0xbef9a3f7, 0xc67178f2
+};
+
+const sha512_word sha512_K[80] = {
+    0x428a2f98d728ae22, 0x7137449123ef65cd, 0xb5c0fbcfec4d3b2f, 0xe9b5dba58189dbbc,
+    0x3956c25bf348b538, 0x59f111f1b605d019, 0x923f82a4af194f9b, 0xab1c5ed5da6d8118,
+    0xd807aa98a3030242, 0x12835b0145706fbe, 0x243185be4ee4b28c, 0x550c7dc3d5ffb4e2,
+    0x72be5d74f27b896f, 0x80deb1fe3b1696b1, 0x9bdc06a725c71235, 0xc19bf174cf692694,
+    0xe49b69c19ef14ad2, 0xefbe4786384f25e3, 0x0fc19dc68b8cd5b5, 0x240ca1cc77ac9c65,
+    0x2de92c6f592b0275, 0x4a7484aa6ea6e483, 0x5cb0a9dcbd41fbd4, 0x76f988da831153b5,
+    0x983e5152ee66dfab, 0xa831c66d2db43210, 0xb00327c898fb213f, 0xbf597fc7beef0ee4,
+    0xc6e00bf33da88fc2, 0xd5a79147930aa725, 0x06ca6351e003826f, 0x142929670a0e6e70,
+    0x27b70a8546d22ffc, 0x2e1b21385c26c926, 0x4d2c6dfc5ac42aed, 0x53380d139d95b3df,
+    0x650a73548baf63de, 0x766a0abb3c77b2a8, 0x81c2c92e47edaee6, 0x92722c851482353b,
+    0xa2bfe8a14cf10364, 0xa81a664bbc423001, 0xc24b8b70d0f89791, 0xc76c51a30654be30,
+    0xd192e819d6ef5218, 0xd69906245565a910, 0xf40e35855771202a, 0x106aa07032bbd1b8,
+    0x19a4c116b8d2d0c8, 0x1e376c085141ab53, 0x2748774cdf8eeb99, 0x34b0bcb5e19b48a8,
+    0x391c0cb3c5c95a63, 0x4ed8aa4ae3418acb, 0x5b9cca4f7763e373, 0x682e6ff3d6b2b8a3,
+    0x748f82ee5defb2fc, 0x78a5636f43172f60, 0x84c87814a1f0ab72, 0x8cc702081a6439ec,
+    0x90befffa23631e28, 0xa4506cebde82bde9, 0xbef9a3f7b2c67915, 0xc67178f2e372532b,
+    0xca273eceea26619c, 0xd186b8c721c0c207, 0xeada7dd6cde0eb1e, 0xf57d4f7fee6ed178,
+    0x06f067aa72176fba, 0x0a637dc5a2c898a6, 0x113f9804bef90dae, 0x1b710b35131c471b,
+    0x28db77f523047d84, 0x32caab7b40c72493, 0x3c9ebe0a15c9bebc, 0x431d67c49c100d4c,
+    0x4cc5d4becb3e42b6, 0x597f299cfc657e2a, 0x5fcb6fab3ad6faec, 0x6c44198c4a475817
+};
+
+// initial hash values, taken from the fractional parts of the square roots of the first 16 primes
+const sha256_state sha224_H0 = {
+    0xc1059ed8, 0x367cd507, 0x3070dd17, 0xf70e5939, 0xffc00b31, 0x68581511, 0x64f98fa7, 0xbefa4fa4
+};
+
+const sha256_state sha256_H0 = {
+    0x6a09e667, 0xbb67ae85, 0x3c6ef372, 0xa54ff53a, 0x510e527f, 0x9b05688c, 0x1f83d9ab, 0x5be0cd19
+};
+
+const sha512_state sha384_H0 = {
+    0xcbbb9d5dc1059ed8, 0x629a292a367cd507, 0x9159015a3070dd17, 0x152fecd8f70e5939,
+    0x67332667ffc00b31, 0x8eb44a8768581511, 0xdb0c2e0d64f98fa7, 0x47b5481dbefa4fa4
+};
+
+const sha512_state sha512_H0 = {
+    0x6a09e667f3bcc908, 0xbb67ae8584caa73b, 0x3c6ef372fe94f82b, 0xa54ff53a5f1d36f1,
+    0x510e527fade682d1, 0x9b05688c2b3e6c1f, 0x1f83d9abfb41bd6b, 0x5be0cd19137e2179
+};
+
+// **************************************************************************************************************
+// SHA-256
+// **************************************************************************************************************
+
+class sha256
+{
+
+public:
+    sha256() = delete;
+
+    static std::string digest(const std::string& str);
+
+    // hashes each string, using the multi-buffer backend where available
+    static std::vector<std::string> digest_batch(const std::vector<std::string>& strs);
+
+    // hashes a full message starting from initial hash value H0 (shared with SHA-224)
+    static sha256_state compute(const sha256_state& H0, const std::string& str);
+    static std::vector<sha256_state> compute_batch(const sha256_state& H0, const std::vector<std::string>& strs);
+
+    // processes num_blocks consecutive 64-byte blocks
+    static void compress(sha256_state& H, const uint8_t* blocks, size_t num_blocks);
+    static void compress_portable(sha256_state& H, const uint8_t* blocks, size_t num_blocks);
+
+    // returns the first num_words words of the state as a hexcode string
+    static std::string hex(const sha256_state& H, uint32_t num_words);
+
+    // streaming interface for messages that arrive in pieces
+    class context;
+
+    static sha256_word sigma0(sha256_word x) { return circ_right_shift(x, 7) ^ circ_right_shift(x, 18) ^ (x >> 3); }
+    static sha256_word sigma1(sha256_word x) { return circ_right_shift(x, 17) ^ circ_right_shift(x, 19) ^ (x >> 10); }
+    static sha256_word Sigma0(sha256_word x) { return circ_right_shift(x, 2) ^ circ_right_shift(x, 13) ^ circ_right_shift(x, 22); }
+    static sha256_word Sigma1(sha256_word x) { return circ_right_shift(x, 6) ^ circ_right_shift(x, 11) ^ circ_right_shift(x, 25); }
+
+#ifdef GV_X86_DISPATCH
+    static void compress_shani(sha256_state& H, const uint8_t* blocks, size_t num_blocks);
+
+    // compresses one block for each of 8 lanes, the state is stored word-major (state[word][lane])
+    // lanes with their bit clear in active keep their previous state
+    static void compress_avx2_x8(sha256_word state[8][8], const uint8_t* const blocks[8], uint32_t active);
+#endif
+
+};
+
+// one round, the caller rotates the roles of a..h instead of moving the values
+#define GV_SHA256_ROUND(a, b, c, d, e, f, g, h, t) \
+    T1 = h + Sigma1(e) + ((e & f) ^ (~e & g)) + sha256_K[t] + W[t]; \
+    d += T1; \
+    h = T1 + Sigma0(a) + ((a & b) ^ (a & c) ^ (b & c));
+
+void sha256::compress_portable(sha256_state& H, const uint8_t* blocks, size_t num_blocks)
+{
+    sha256_word W[64];
+    sha256_word T1;
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = blocks + 64*i;
+
+        // message schedule
+        for (int t = 0; t < 16; ++t)
+            W[t] = load_be<sha256_word>(block + 4*t);
+        for (int t = 16; t < 64; ++t)
+            W[t] = sigma1(W[t - 2]) + W[t - 7] + sigma0(W[t - 15]) + W[t - 16];
+
+        sha256_word a = H[0], b = H[1], c = H[2], d = H[3], e = H[4], f = H[5], g = H[6], h = H[7];
+
+        // main loop, after 8 rounds every variable is back in its original role
+        for (int t = 0; t < 64; t += 8)
+        {
+            GV_SHA256_ROUND(a, b, c, d, e, f, g, h, t + 0);
+            GV_SHA256_ROUND(h, a, b, c, d, e, f, g, t + 1);
+            GV_SHA256_ROUND(g, h, a, b, c, d, e, f, t + 2);
+            GV_SHA256_ROUND(f, g, h, a, b, c, d, e, t + 3);
+            GV_SHA256_ROUND(e, f, g, h, a, b, c, d, t + 4);
+            GV_SHA256_ROUND(d, e, f, g, h, a, b, c, t + 5);
+            GV_SHA256_ROUND(c, d, e, f, g, h, a, b, t + 6);
+            GV_SHA256_ROUND(b, c, d, e, f, g, h, a, t + 7);
+        }
+
+        H[0] += a; H[1] += b; H[2] += c; H[3] += d;
+        H[4] += e; H[5] += f; H[6] += g; H[7] += h;
+    }
+}
+
+#undef GV_SHA256_ROUND
+
+void sha256::compress(sha256_state& H, const uint8_t* blocks, size_t num_blocks)
+{
+#ifdef GV_X86_DISPATCH
+    if (cpu().sha && cpu().sse41 && cpu().ssse3)
+    {
+        compress_shani(H, blocks, num_blocks);
+        return;
+    }
+#endif
+    compress_portable(H, blocks, num_blocks);
+}
+
+sha256_state sha256::compute(const sha256_state& H0, const std::string& str)
+{
+    sha256_state H = H0;
+    const uint8_t* data = (const uint8_t*)str.data();
+
+    // full blocks are processed in place, only the final partial block is copied for padding
+    size_t num_full_blocks = str.size() / 64;
+    compress(H, data, num_full_blocks);
+
+    std::vector<uint8_t> tail = md_pad(data + 64*num_full_blocks, str.size() % 64, str.size(), 64, 8);
+    compress(H, tail.data(), tail.size() / 64);
+
+    return H;
+}
+
+std::string sha256::hex(const sha256_state& H, uint32_t num_words)
+{
+    std::string hexcode;
+    for (uint32_t i = 0; i < num_words; ++i)
+        hexcode += to_hexcode<sha256_word>(H[i]);
+    return hexcode;
+}
+
+std::string sha256::digest(const std::string& str)
+{
+    return hex(compute(sha256_H0, str), 8);
+}
+
+std::vector<sha256_state> sha256::compute_batch(const sha256_state& H0, const std::vector<std::string>& strs)
+{
+    std::vector<sha256_state> out(strs.size());
+
+#ifdef GV_X86_DISPATCH
+    // with SHA-NI a single message is already faster than 8 AVX2 lanes
+    if (cpu().avx2 && !cpu().sha)
+    {
+        auto pad = [](const uint8_t* tail, size_t tail_len, uint64_t msg_len) { return md_pad(tail, tail_len, msg_len, 64, 8); };
+
+        for (size_t first = 0; first < strs.size(); first += sha256_lanes)
+        {
+            uint32_t num_lanes = (strs.size() - first < sha256_lanes) ? strs.size() - first : sha256_lanes;
+            lane_schedule<sha256_lanes, 64> schedule(&strs[first], num_lanes, pad);
+
+            alignas(32) sha256_word state[8][8];
+            for (int w = 0; w < 8; ++w)
+                for (uint32_t l = 0; l < sha256_lanes; ++l)
+                    state[w][l] = H0[w];
+
+            for (size_t b = 0; b < schedule.num_blocks(); ++b)
+            {
+                const uint8_t* blocks[8];
+                uint32_t active = schedule.blocks(b, blocks);
+                compress_avx2_x8(state, blocks, active);
+            }
+
+            for (uint32_t l = 0; l < num_lanes; ++l)
+                for (int w = 0; w < 8; ++w)
+                    out[first + l][w] = state[w][l];
+        }
+        return out;
+    }
+#endif
+
+    for (size_t i = 0; i < strs.size(); ++i)
+        out[i] = compute(H0, strs[i]);
+    return out;
+}
+
+std::vector<std::string> sha256::digest_batch(const std::vector<std::string>& strs)
+{
+    std::vector<sha256_state> states = compute_batch(sha256_H0, strs);
+    std::vector<std::string> digests(states.size());
+    for (size_t i = 0; i < states.size(); ++i)
+        digests[i] = hex(states[i], 8);
+    return digests;
+}
+
+// streaming SHA-256, and SHA-224 through its subclass sha224::context
+// the midstate can be saved with export_state and resumed with import_state, as for sha1::context
+class sha256::context
+{
+
+public:
+    context() : context(sha256_H0, 8, midstate_algorithm::sha256) {}
+
+    void update(const uint8_t* data, size_t len);
+    void update(std::string_view str) { update((const uint8_t*)str.data(), str.size()); }
+
+    // digest of everything hashed so far, the context can still be updated afterwards
+    sha256_digest finalize() const { return state_to_digest<32>(final_state()); }
+    std::string digest() const { return hex(final_state(), num_words); }
+
+    // number of message bytes hashed so far, i.e. the offset to resume from
+    uint64_t length() const { return msg_len; }
+
+    // serialises the hash state, the message length and the partial block (format in crypto_useful.hpp)
+    std::string export_state() const;
+
+    // throws std::invalid_argument if data is not a valid SHA-256 midstate
+    static context import_state(const std::string& data);
+
+protected:
+    context(const sha256_state& H0, uint32_t num_words, midstate_algorithm algorithm)
+        : H(H0), num_words(num_words), algorithm(algorithm) {}
+
+    // the full hash value after padding, which SHA-224 truncates
+    sha256_state final_state() const;
+
+    sha256_state H;
+    std::array<uint8_t, 64> buffer = {};
+    uint64_t msg_len = 0;
+
+    // words in the digest and the midstate id, which differ for SHA-224
+    uint32_t num_words;
+    midstate_algorithm algorithm;
+};
+
+void sha256::context::update(const uint8_t* data, size_t len)
+{
+    size_t buffered = msg_len % 64;
+    msg_len += len;
+
+    // top up a partial block first
+    if (buffered > 0)
+    {
+        size_t take = (len < 64 - buffered) ? len : 64 - buffered;
+        std::memcpy(buffer.data() + buffered, data, take);
+        data += take;
+        len -= take;
+        if (buffered + take < 64)
+            return;
+        compress(H, buffer.data(), 1);
+    }
+
+    // whole blocks straight from the input
+    compress(H, data, len / 64);
+    std::memcpy(buffer.data(), data + 64*(len / 64), len % 64);
+}
+
+sha256_state sha256::context::final_state() const
+{
+    sha256_state H_final = H;
+    std::vector<uint8_t> tail = md_pad(buffer.data(), msg_len % 64, msg_len, 64, 8);
+    compress(H_final, tail.data(), tail.size() / 64);
+    return H_final;
+}
+
+std::string sha256::context::export_state() const
+{
+    return export_midstate(algorithm, msg_len, H, buffer.data(), 64);
+}
+
+sha256::context sha256::context::import_state(const std::string& data)
+{
+    context ctx;
+    import_midstate(data, ctx.algorithm, ctx.msg_len, ctx.H, ctx.buffer.data(), 64);
+    return ctx;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// based on the Intel SHA extensions reference code
+// the state is held as ABEF and CDGH, each sha256rnds2 performs 2 rounds
+__attribute__((target("sha,sse4.1,ssse3")))
+void sha256::compress_shani(sha256_state& H, const uint8_t* blocks, size_t num_blocks)
+{
+    const __m128i bswap_mask = _mm_set_epi64x(0x0c0d0e0f08090a0bULL, 0x0405060700010203ULL);
+
+    __m128i tmp    = _mm_loadu_si128((const __m128i*)&H[0]);   // DCBA
+    __m128i state1 = _mm_loadu_si128((const __m128i*)&H[4]);   // HGFE
+    tmp    = _mm_shuffle_epi32(tmp, 0xb1);                     // CDAB
+    state1 = _mm_shuffle_epi32(state1, 0x1b);                  // EFGH
+    __m128i state0 = _mm_alignr_epi8(tmp, state1, 8);          // ABEF
+    state1 = _mm_blend_epi16(state1, tmp, 0xf0);               // CDGH
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = blocks + 64*i;
+        __m128i abef_save = state0;
+        __m128i cdgh_save = state1;
+
+        // msg[g % 4] holds schedule words W[4g .. 4g+3]
+        __m128i msg[4];
+
+        #pragma GCC unroll 16
+        for (int g = 0; g < 16; ++g)
+        {
+            if (g < 4)
+                msg[g] = _mm_shuffle_epi8(_mm_loadu_si128((const __m128i*)(block + 16*g)), bswap_mask);
+
+            __m128i m = _mm_add_epi32(msg[g % 4], _mm_loadu_si128((const __m128i*)&sha256_K[4*g]));
+            state1 = _mm_sha256rnds2_epu32(state1, state0, m);
+
+            // W[4(g+1) ..] = sigma1 terms + W[t-7] + (sigma0 terms + W[t-16], from sha256msg1 two groups ago)
+            if (g >= 3 && g <= 14)
+            {
+                __m128i w7 = _mm_alignr_epi8(msg[g % 4], msg[(g + 3) % 4], 4);
+                msg[(g + 1) % 4] = _mm_sha256msg2_epu32(_mm_add_epi32(msg[(g + 1) % 4], w7), msg[g % 4]);
+            }
+
+            m = _mm_shuffle_epi32(m, 0x0e);
+            state0 = _mm_sha256rnds2_epu32(state0, state1, m);
+
+            if (g >= 1 && g <= 12)
+                msg[(g + 3) % 4] = _mm_sha256msg1_epu32(msg[(g + 3) % 4], msg[g % 4]);
+        }
+
+        state0 = _mm_add_epi32(state0, abef_save);
+        state1 = _mm_add_epi32(state1, cdgh_save);
+    }
+
+    tmp    = _mm_shuffle_epi32(state0, 0x1b);                  // FEBA
+    state1 = _mm_shuffle_epi32(state1, 0xb1);                  // DCHG
+    state0 = _mm_blend_epi16(tmp, state1, 0xf0);               // DCBA
+    state1 = _mm_alignr_epi8(state1, tmp, 8);                  // HGFE
+
+    _mm_storeu_si128((__m128i*)&H[0], state0);
+    _mm_storeu_si128((__m128i*)&H[4], state1);
+}
+
+#define GV_ROTR32_X8(x, n) _mm256_or_si256(_mm256_srli_epi32(x, n), _mm256_slli_epi32(x, 32 - (n)))
+
+__attribute__((target("avx2")))
+void sha256::compress_avx2_x8(sha256_word state[8][8], const uint8_t* const blocks[8], uint32_t active)
+{
+    const __m256i bswap_mask = _mm256_setr_epi8(3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12,
+                                                3, 2, 1, 0, 7, 6, 5, 4, 11, 10, 9, 8, 15, 14, 13, 12);
+
+    // W[t] for all lanes, a 16 word window of the schedule
+    __m256i W[16];
+    for (int half = 0; half < 2; ++half)
+    {
+        __m256i r[8];
+        for (int l = 0; l < 8; ++l)
+            r[l] = _mm256_loadu_si256((const __m256i*)(blocks[l] + 32*half));
+        transpose_8x8_epi32(r);
+        for (int i = 0; i < 8; ++i)
+            W[8*half + i] = _mm256_shuffle_epi8(r[i], bswap_mask);
+    }
+
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i)
+        v[i] = _mm256_load_si256((const __m256i*)state[i]);
+
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 64; ++t)
+    {
+        __m256i w;
+        if (t < 16)
+            w = W[t];
+        else
+        {
+            __m256i w2  = W[(t - 2) % 16];
+            __m256i w15 = W[(t - 15) % 16];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR32_X8(w15, 7), GV_ROTR32_X8(w15, 18)), _mm256_srli_epi32(w15, 3));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR32_X8(w2, 17), GV_ROTR32_X8(w2, 19)), _mm256_srli_epi32(w2, 10));
+            w = _mm256_add_epi32(_mm256_add_epi32(s1, W[(t - 7) % 16]), _mm256_add_epi32(s0, W[t % 16]));
+            W[t % 16] = w;
+        }
+
+        __m256i S1  = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR32_X8(e, 6), GV_ROTR32_X8(e, 11)), GV_ROTR32_X8(e, 25));
+        __m256i ch  = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i T1  = _mm256_add_epi32(_mm256_add_epi32(h, S1), _mm256_add_epi32(ch, _mm256_add_epi32(w, _mm256_set1_epi32(sha256_K[t]))));
+        __m256i S0  = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR32_X8(a, 2), GV_ROTR32_X8(a, 13)), GV_ROTR32_X8(a, 22));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i T2  = _mm256_add_epi32(S0, maj);
+
+        h = g; g = f; f = e;
+        e = _mm256_add_epi32(d, T1);
+        d = c; c = b; b = a;
+        a = _mm256_add_epi32(T1, T2);
+    }
+
+    __m256i out[8] = {a, b, c, d, e, f, g, h};
+    __m256i mask = lane_mask_epi32(active);
+    for (int i = 0; i < 8; ++i)
+    {
+        __m256i updated = _mm256_add_epi32(v[i], out[i]);
+        _mm256_store_si256((__m256i*)state[i], _mm256_blendv_epi8(v[i], updated, mask));
+    }
+}
+
+#undef GV_ROTR32_X8
+
+#endif
+
+// **************************************************************************************************************
+// SHA-224
+// **************************************************************************************************************
+
+// SHA-256 with a different initial hash value, truncated to 224 bits
+class sha224
+{
+
+public:
+    sha224() = delete;
+
+    static std::string digest(const std::string& str)
+    {
+        return sha256::hex(sha256::compute(sha224_H0, str), 7);
+    }
+
+    static std::vector<std::string> digest_batch(const std::vector<std::string>& strs)
+    {
+        std::vector<sha256_state> states = sha256::compute_batch(sha224_H0, strs);
+        std::vector<std::string> digests(states.size());
+        for (size_t i = 0; i < states.size(); ++i)
+            digests[i] = sha256::hex(states[i], 7);
+        return digests;
+    }
+
+    // streaming SHA-224, as sha256::context
+    // inherited privately, so that the untruncated SHA-256 finalize is not reachable through a base reference
+    class context : private sha256::context
+    {
+
+    public:
+        context() : sha256::context(sha224_H0, 7, midstate_algorithm::sha224) {}
+
+        using sha256::context::update;
+        using sha256::context::digest;
+        using sha256::context::length;
+        using sha256::context::export_state;
+
+        sha224_digest finalize() const { return state_to_digest<28>(final_state()); }
+
+        // throws std::invalid_argument if data is not a valid SHA-224 midstate
+        static context import_state(const std::string& data)
+        {
+            context ctx;
+            import_midstate(data, ctx.algorithm, ctx.msg_len, ctx.H, ctx.buffer.data(), 64);
+            return ctx;
+        }
+    };
+
+};
+
+// **************************************************************************************************************
+// SHA-512
+// **************************************************************************************************************
+
+class sha512
+{
+
+public:
+    sha512() = delete;
+
+    static std::string digest(const std::string& str);
+
+    // hashes each string, using the multi-buffer backend where available
+    static std::vector<std::string> digest_batch(const std::vector<std::string>& strs);
+
+    // hashes a full message starting from initial hash value H0 (shared with SHA-384)
+    static sha512_state compute(const sha512_state& H0, const std::string& str);
+    static std::vector<sha512_state> compute_batch(const sha512_state& H0, const std::vector<std::string>& strs);
+
+    // processes num_blocks consecutive 128-byte blocks
+    static void compress(sha512_state& H, const uint8_t* blocks, size_t num_blocks);
+
+    // returns the first num_words words of the state as a hexcode string
+    static std::string hex(const sha512_state& H, uint32_t num_words);
+
+    // streaming interface for messages that arrive in pieces
+    class context;
+
+    static sha512_word sigma0(sha512_word x) { return circ_right_shift(x, 1) ^ circ_right_shift(x, 8) ^ (x >> 7); }
+    static sha512_word sigma1(sha512_word x) { return circ_right_shift(x, 19) ^ circ_right_shift(x, 61) ^ (x >> 6); }
+    static sha512_word Sigma0(sha512_word x) { return circ_right_shift(x, 28) ^ circ_right_shift(x, 34) ^ circ_right_shift(x, 39); }
+    static sha512_word Sigma1(sha512_word x) { return circ_right_shift(x, 14) ^ circ_right_shift(x, 18) ^ circ_right_shift(x, 41); }
+
+#ifdef GV_X86_DISPATCH
+    // compresses one block for each of 4 lanes, the state is stored word-major (state[word][lane])
+    // lanes with their bit clear in active keep their previous state
+    static void compress_avx2_x4(sha512_word state[8][4], const uint8_t* const blocks[4], uint32_t active);
+#endif
+
+};
+
+#define GV_SHA512_ROUND(a, b, c, d, e, f, g, h, t) \
+    T1 = h + Sigma1(e) + ((e & f) ^ (~e & g)) + sha512_K[t] + W[t]; \
+    d += T1; \
+    h = T1 + Sigma0(a) + ((a & b) ^ (a & c) ^ (b & c));
+
+void sha512::compress(sha512_state& H, const uint8_t* blocks, size_t num_blocks)
+{
+    sha512_word W[80];
+    sha512_word T1;
+
+    for (size_t i = 0; i < num_blocks; ++i)
+    {
+        const uint8_t* block = blocks + 128*i;
+
+        for (int t = 0; t < 16; ++t)
+            W[t] = load_be<sha512_word>(block + 8*t);
+        for (int t = 16; t < 80; ++t)
+            W[t] = sigma1(W[t - 2]) + W[t - 7] + sigma0(W[t - 15]) + W[t - 16];
+
+        sha512_word a = H[0], b = H[1], c = H[2], d = H[3], e = H[4], f = H[5], g = H[6], h = H[7];
+
+        for (int t = 0; t < 80; t += 8)
+        {
+            GV_SHA512_ROUND(a, b, c, d, e, f, g, h, t + 0);
+            GV_SHA512_ROUND(h, a, b, c, d, e, f, g, t + 1);
+            GV_SHA512_ROUND(g, h, a, b, c, d, e, f, t + 2);
+            GV_SHA512_ROUND(f, g, h, a, b, c, d, e, t + 3);
+            GV_SHA512_ROUND(e, f, g, h, a, b, c, d, t + 4);
+            GV_SHA512_ROUND(d, e, f, g, h, a, b, c, t + 5);
+            GV_SHA512_ROUND(c, d, e, f, g, h, a, b, t + 6);
+            GV_SHA512_ROUND(b, c, d, e, f, g, h, a, t + 7);
+        }
+
+        H[0] += a; H[1] += b; H[2] += c; H[3] += d;
+        H[4] += e; H[5] += f; H[6] += g; H[7] += h;
+    }
+}
+
+#undef GV_SHA512_ROUND
+
+sha512_state sha512::compute(const sha512_state& H0, const std::string& str)
+{
+    sha512_state H = H0;
+    const uint8_t* data = (const uint8_t*)str.data();
+
+    size_t num_full_blocks = str.size() / 128;
+    compress(H, data, num_full_blocks);
+
+    std::vector<uint8_t> tail = md_pad(data + 128*num_full_blocks, str.size() % 128, str.size(), 128, 16);
+    compress(H, tail.data(), tail.size() / 128);
+
+    return H;
+}
+
+std::string sha512::hex(const sha512_state& H, uint32_t num_words)
+{
+    std::string hexcode;
+    for (uint32_t i = 0; i < num_words; ++i)
+        hexcode += to_hexcode<sha512_word>(H[i]);
+    return hexcode;
+}
+
+std::string sha512::digest(const std::string& str)
+{
+    return hex(compute(sha512_H0, str), 8);
+}
+
+std::vector<sha512_state> sha512::compute_batch(const sha512_state& H0, const std::vector<std::string>& strs)
+{
+    std::vector<sha512_state> out(strs.size());
+
+#ifdef GV_X86_DISPATCH
+    if (cpu().avx2)
+    {
+        auto pad = [](const uint8_t* tail, size_t tail_len, uint64_t msg_len) { return md_pad(tail, tail_len, msg_len, 128, 16); };
+
+        for (size_t first = 0; first < strs.size(); first += sha512_lanes)
+        {
+            uint32_t num_lanes = (strs.size() - first < sha512_lanes) ? strs.size() - first : sha512_lanes;
+            lane_schedule<sha512_lanes, 128> schedule(&strs[first], num_lanes, pad);
+
+            alignas(32) sha512_word state[8][4];
+            for (int w = 0; w < 8; ++w)
+                for (uint32_t l = 0; l < sha512_lanes; ++l)
+                    state[w][l] = H0[w];
+
+            for (size_t b = 0; b < schedule.num_blocks(); ++b)
+            {
+                const uint8_t* blocks[4];
+                uint32_t active = schedule.blocks(b, blocks);
+                compress_avx2_x4(state, blocks, active);
+            }
+
+            for (uint32_t l = 0; l < num_lanes; ++l)
+                for (int w = 0; w < 8; ++w)
+                    out[first + l][w] = state[w][l];
+        }
+        return out;
+    }
+#endif
+
+    for (size_t i = 0; i < strs.size(); ++i)
+        out[i] = compute(H0, strs[i]);
+    return out;
+}
+
+std::vector<std::string> sha512::digest_batch(const std::vector<std::string>& strs)
+{
+    std::vector<sha512_state> states = compute_batch(sha512_H0, strs);
+    std::vector<std::string> digests(states.size());
+    for (size_t i = 0; i < states.size(); ++i)
+        digests[i] = hex(states[i], 8);
+    return digests;
+}
+
+// streaming SHA-512, and SHA-384 through its subclass sha384::context
+// the midstate can be saved with export_state and resumed with import_state, as for sha1::context
+class sha512::context
+{
+
+public:
+    context() : context(sha512_H0, 8, midstate_algorithm::sha512) {}
+
+    void update(const uint8_t* data, size_t len);
+    void update(std::string_view str) { update((const uint8_t*)str.data(), str.size()); }
+
+    // digest of everything hashed so far, the context can still be updated afterwards
+    sha512_digest finalize() const { return state_to_digest<64>(final_state()); }
+    std::string digest() const { return hex(final_state(), num_words); }
+
+    // number of message bytes hashed so far, i.e. the offset to resume from
+    uint64_t length() const { return msg_len; }
+
+    // serialises the hash state, the message length and the partial block (format in crypto_useful.hpp)
+    std::string export_state() const;
+
+    // throws std::invalid_argument if data is not a valid SHA-512 midstate
+    static context import_state(const std::string& data);
+
+protected:
+    context(const sha512_state& H0, uint32_t num_words, midstate_algorithm algorithm)
+        : H(H0), num_words(num_words), algorithm(algorithm) {}
+
+    // the full hash value after padding, which SHA-384 truncates
+    sha512_state final_state() const;
+
+    sha512_state H;
+    std::array<uint8_t, 128> buffer = {};
+    uint64_t msg_len = 0;
+
+    // words in the digest and the midstate id, which differ for SHA-384
+    uint32_t num_words;
+    midstate_algorithm algorithm;
+};
+
+void sha512::context::update(const uint8_t* data, size_t len)
+{
+    size_t buffered = msg_len % 128;
+    msg_len += len;
+
+    // top up a partial block first
+    if (buffered > 0)
+    {
+        size_t take = (len < 128 - buffered) ? len : 128 - buffered;
+        std::memcpy(buffer.data() + buffered, data, take);
+        data += take;
+        len -= take;
+        if (buffered + take < 128)
+            return;
+        compress(H, buffer.data(), 1);
+    }
+
+    // whole blocks straight from the input
+    compress(H, data, len / 128);
+    std::memcpy(buffer.data(), data + 128*(len / 128), len % 128);
+}
+
+sha512_state sha512::context::final_state() const
+{
+    sha512_state H_final = H;
+    std::vector<uint8_t> tail = md_pad(buffer.data(), msg_len % 128, msg_len, 128, 16);
+    compress(H_final, tail.data(), tail.size() / 128);
+    return H_final;
+}
+
+std::string sha512::context::export_state() const
+{
+    return export_midstate(algorithm, msg_len, H, buffer.data(), 128);
+}
+
+sha512::context sha512::context::import_state(const std::string& data)
+{
+    context ctx;
+    import_midstate(data, ctx.algorithm, ctx.msg_len, ctx.H, ctx.buffer.data(), 128);
+    return ctx;
+}
+
+#ifdef GV_X86_DISPATCH
+
+#define GV_ROTR64_X4(x, n) _mm256_or_si256(_mm256_srli_epi64(x, n), _mm256_slli_epi64(x, 64 - (n)))
+
+__attribute__((target("avx2")))
+void sha512::compress_avx2_x4(sha512_word state[8][4], const uint8_t* const blocks[4], uint32_t active)
+{
+    const __m256i bswap_mask = _mm256_setr_epi8(7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8,
+                                                7, 6, 5, 4, 3, 2, 1, 0, 15, 14, 13, 12, 11, 10, 9, 8);
+
+    __m256i W[16];
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+        __m256i r[4];
+        for (int l = 0; l < 4; ++l)
+            r[l] = _mm256_loadu_si256((const __m256i*)(blocks[l] + 32*quarter));
+        transpose_4x4_epi64(r);
+        for (int i = 0; i < 4; ++i)
+            W[4*quarter + i] = _mm256_shuffle_epi8(r[i], bswap_mask);
+    }
+
+    __m256i v[8];
+    for (int i = 0; i < 8; ++i)
+        v[i] = _mm256_load_si256((const __m256i*)state[i]);
+
+    __m256i a = v[0], b = v[1], c = v[2], d = v[3], e = v[4], f = v[5], g = v[6], h = v[7];
+
+    for (int t = 0; t < 80; ++t)
+    {
+        __m256i w;
+        if (t < 16)
+            w = W[t];
+        else
+        {
+            __m256i w2  = W[(t - 2) % 16];
+            __m256i w15 = W[(t - 15) % 16];
+            __m256i s0 = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR64_X4(w15, 1), GV_ROTR64_X4(w15, 8)), _mm256_srli_epi64(w15, 7));
+            __m256i s1 = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR64_X4(w2, 19), GV_ROTR64_X4(w2, 61)), _mm256_srli_epi64(w2, 6));
+            w = _mm256_add_epi64(_mm256_add_epi64(s1, W[(t - 7) % 16]), _mm256_add_epi64(s0, W[t % 16]));
+            W[t % 16] = w;
+        }
+
+        __m256i S1  = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR64_X4(e, 14), GV_ROTR64_X4(e, 18)), GV_ROTR64_X4(e, 41));
+        __m256i ch  = _mm256_xor_si256(_mm256_and_si256(e, f), _mm256_andnot_si256(e, g));
+        __m256i T1  = _mm256_add_epi64(_mm256_add_epi64(h, S1), _mm256_add_epi64(ch, _mm256_add_epi64(w, _mm256_set1_epi64x(sha512_K[t]))));
+        __m256i S0  = _mm256_xor_si256(_mm256_xor_si256(GV_ROTR64_X4(a, 28), GV_ROTR64_X4(a, 34)), GV_ROTR64_X4(a, 39));
+        __m256i maj = _mm256_or_si256(_mm256_and_si256(a, b), _mm256_and_si256(c, _mm256_or_si256(a, b)));
+        __m256i T2  = _mm256_add_epi64(S0, maj);
+
+        h = g; g = f; f = e;
+        e = _mm256_add_epi64(d, T1);
+        d = c; c = b; b = a;
+        a = _mm256_add_epi64(T1, T2);
+    }
+
+    __m256i out[8] = {a, b, c, d, e, f, g, h};
+    __m256i mask = lane_mask_epi64(active);
+    for (int i = 0; i < 8; ++i)
+    {
+        __m256i updated = _mm256_add_epi64(v[i], out[i]);
+        _mm256_store_si256((__m256i*)state[i], _mm256_blendv_epi8(v[i], updated, mask));
+    }
+}
+
+#undef GV_ROTR64_X4
+
+#endif
+
+// **************************************************************************************************************
+// SHA-384
+// **************************************************************************************************************
+
+// SHA-512 with a different initial hash value, truncated to 384 bits
+class sha384
+{
+
+public:
+    sha384() = delete;
+
+    static std::string digest(const std::string& str)
+    {
+        return sha512::hex(sha512::compute(sha384_H0, str), 6);
+    }
+
+    static std::vector<std::string> digest_batch(const std::vector<std::string>& strs)
+    {
+        std::vector<sha512_state> states = sha512::compute_batch(sha384_H0, strs);
+        std::vector<std::string> digests(states.size());
+        for (size_t i = 0; i < states.size(); ++i)
+            digests[i] = sha512::hex(states[i], 6);
+        return digests;
+    }
+
+    // streaming SHA-384, as sha512::context
+    // inherited privately, so that the untruncated SHA-512 finalize is not reachable through a base reference
+    class context : private sha512::context
+    {
+
+    public:
+        context() : sha512::context(sha384_H0, 6, midstate_algorithm::sha384) {}
+
+        using sha512::context::update;
+        using sha512::context::digest;
+        using sha512::context::length;
+        using sha512::context::export_state;
+
+        sha384_digest finalize() const { return state_to_digest<48>(final_state()); }
+
+        // throws std::invalid_argument if data is not a valid SHA-384 midstate
+        static context import_state(const std::string& data)
+        {
+            context ctx;
+            import_midstate(data, ctx.algorithm, ctx.msg_len, ctx.H, ctx.buffer.data(), 128);
+            return ctx;
+        }
+    };
+
+};
+
+} // namespace gv
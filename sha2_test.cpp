@@ -0,0 +1,125 @@
+#include <iostream>
+#include "sha2.hpp"
+
+// FIPS 180-4 example messages (one block, empty, and the 448-bit message that pads into a second block)
+struct sha2_vector
+{
+    const char* message;
+    const char* sha224;
+    const char* sha256;
+    const char* sha384;
+    const char* sha512;
+};
+
+const sha2_vector sha2_vectors[] = {
+    {"abc",
+     "23097d223405d8228642a477bda255b32aadbce4bda0b3f7e36c9da7",
+     "ba7816bf8f01cfea414140de5dae2223b00361a396177a9cb410ff61f20015ad",
+     "cb00753f45a35e8bb5a03d699ac65007272c32ab0eded1631a8b605a43ff5bed8086072ba1e7cc2358baeca134c825a7",
+     "ddaf35a193617abacc417349ae20413112e6fa4e89a97ea20a9eeee64b55d39a2192992a274fc1a836ba3c23a3feebbd454d4423643ce80e2a9ac94fa54ca49f"},
+    {"",
+     "d14a028c2a3a2bc9476102bb288234c415a2b01f828ea62ac5b3e42f",
+     "e3b0c44298fc1c149afbf4c8996fb92427ae41e4649b934ca495991b7852b855",
+     "38b060a751ac96384cd9327eb1b1e36a21fdb71114be07434c0cc7bf63f6e1da274edebfe76f65fbd51ad2f14898b95b",
+     "cf83e1357eefb8bdf1542850d66d8007d620e4050b5715dc83f4a921d36ce9ce47d0d13c5d85f2b0ff8318d2877eec2f63b931bd47417a81a538327af927da3e"},
+    {"abcdbcdecdefdefgefghfghighijhijkijkljklmklmnlmnomnopnopq",
+     "75388b16512776cc5dba5da1fd890150b0c6455cb4f58b1952522525",
+     "248d6a61d20638b8e5c026930c3e6039a33ce45964ff2167f6ecedd419db06c1",
+     "3391fdddfc8dc7393707a65b1b4709397cf8b1d162af05abfe8f450de5f36bc6b0455a8520bc4e6f5fe95b1fe3c8452b",
+     "204a8fc6dda82f0a0ced7beb8e08a41657c16ef468b228a8279be331a703c33596fd15c13b1b07f9aa1d3bea57789ca031ad85c7a71dd70354ec631238ca3445"},
+};
+
+// hashes the message in two pieces through a midstate, finalize and digest() must agree
+template <typename Context>
+std::string resumed_digest(const std::string& message)
+{
+    Context first;
+    first.update(message.substr(0, message.size() / 2));
+    Context second = Context::import_state(first.export_state());
+    second.update(message.substr(message.size() / 2));
+
+    std::string digest = gv::bytes_to_hexcode(second.finalize());
+    return digest == second.digest() ? digest : "finalize differs from digest()";
+}
+
+int main(int argc, char* argv[]) {
+    std::vector<std::string> messages;
+    for (const sha2_vector& v : sha2_vectors)
+        messages.push_back(v.message);
+
+    std::vector<std::string> batch_224 = gv::sha224::digest_batch(messages);
+    std::vector<std::string> batch_256 = gv::sha256::digest_batch(messages);
+    std::vector<std::string> batch_384 = gv::sha384::digest_batch(messages);
+    std::vector<std::string> batch_512 = gv::sha512::digest_batch(messages);
+
+    // every variant through the one-shot, batch and streaming interfaces
+    int num_wrong = 0;
+    for (size_t i = 0; i < messages.size(); ++i) {
+        const sha2_vector& v = sha2_vectors[i];
+        const std::string& m = messages[i];
+
+        std::string got[4][3] = {
+            {gv::sha224::digest(m), batch_224[i], resumed_digest<gv::sha224::context>(m)},
+            {gv::sha256::digest(m), batch_256[i], resumed_digest<gv::sha256::context>(m)},
+            {gv::sha384::digest(m), batch_384[i], resumed_digest<gv::sha384::context>(m)},
+            {gv::sha512::digest(m), batch_512[i], resumed_digest<gv::sha512::context>(m)}};
+        const char* expected[4] = {v.sha224, v.sha256, v.sha384, v.sha512};
+
+        for (int a = 0; a < 4; ++a)
+            for (int k = 0; k < 3; ++k)
+                if (got[a][k] != expected[a]) {
+                    std::cout << "\"" << m << "\": " << got[a][k] << " (should be " << expected[a] << ")" << std::endl;
+                    ++num_wrong;
+                }
+    }
+
+#ifdef GV_X86_DISPATCH
+    // the 8-lane SHA-256 kernel is only used by digest_batch on CPUs without SHA-NI, so call it directly
+    if (gv::cpu().avx2) {
+        std::vector<std::string> lanes;
+        for (uint32_t l = 0; l < gv::sha256_lanes; ++l)
+            lanes.push_back(messages[l % messages.size()]);
+
+        auto pad = [](const uint8_t* tail, size_t tail_len, uint64_t msg_len) { return gv::md_pad(tail, tail_len, msg_len, 64, 8); };
+        gv::lane_schedule<gv::sha256_lanes, 64> schedule(lanes.data(), gv::sha256_lanes, pad);
+
+        alignas(32) gv::sha256_word state[8][8];
+        for (int w = 0; w < 8; ++w)
+            for (uint32_t l = 0; l < gv::sha256_lanes; ++l)
+                state[w][l] = gv::sha256_H0[w];
+
+        for (size_t b = 0; b < schedule.num_blocks(); ++b) {
+            const uint8_t* blocks[8];
+            uint32_t active = schedule.blocks(b, blocks);
+            gv::sha256::compress_avx2_x8(state, blocks, active);
+        }
+
+        for (uint32_t l = 0; l < gv::sha256_lanes; ++l) {
+            gv::sha256_state H;
+            for (int w = 0; w < 8; ++w)
+                H[w] = state[w][l];
+
+            const char* expected = sha2_vectors[l % messages.size()].sha256;
+            if (gv::sha256::hex(H, 8) != expected) {
+                std::cout << "AVX2 lane " << l << ": " << gv::sha256::hex(H, 8) << " (should be " << expected << ")" << std::endl;
+                ++num_wrong;
+            }
+        }
+    }
+#endif
+
+    std::cout << "FIPS 180-4 examples: " << num_wrong << " wrong" << std::endl;
+
+    if (argc > 1) {
+
+        std::string input(argv[1]);
+
+        std::cout << input << " >>>> SHA-224 >>>> " << gv::sha224::digest(input) << std::endl;
+        std::cout << input << " >>>> SHA-256 >>>> " << gv::sha256::digest(input) << std::endl;
+        std::cout << input << " >>>> SHA-384 >>>> " << gv::sha384::digest(input) << std::endl;
+        std::cout << input << " >>>> SHA-512 >>>> " << gv::sha512::digest(input) << std::endl;
+
+    }
+
+    return num_wrong == 0 ? 0 : 1;
+}
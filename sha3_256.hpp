@@ -24,7 +24,9 @@
 
 #include <iostream>
 #include <string>
+#include <string_view>
 #include <bitset>
+#include <array>
 #include <assert.h>
 #include <cstring>
 #include <algorithm>
@@ -40,152 +42,143 @@ namespace sha3_256
 
 //********************************************************************************************************************
 
-// FUNCTION DECLARATIONS
+// DATATYPES
 
-// step mappings
-std::vector<uint64_t> theta(const std::vector<uint64_t>& state);
-std::vector<uint64_t> pi(const std::vector<uint64_t>& state);
-std::vector<uint64_t> rho(const std::vector<uint64_t>& state);
-std::vector<uint64_t> chi(const std::vector<uint64_t>& state);
-std::vector<uint64_t> iota(const int& i, const std::vector<uint64_t>& state);
-uint64_t RC(const int& i);
-
-// main digest fcn
-std::string digest(const std::string& str);
+// internal state of 25 * 64-bit lanes, lane (x, y) is stored at index 5*y + x
+using state_t = std::array<uint64_t, 25>;
 
-// hexcode fcns
-template <typename T>
-std::string hex(const std::vector<T>& x);
-template <typename T>
-void print_hex_grid(std::vector<T>& x);
+using digest_t = std::array<uint8_t, 32>;
 
-//********************************************************************************************************************
-
-// message digest
-std::string digest(const std::string& str)
-{
-    // PADDING
+// block size in bytes (= rate / 8)
+const uint32_t block_bytes = 136;
 
-    int width = 1600;
-    int capacity = 2*256;
-    int rate = width - capacity;        // 1088
+// number of messages hashed together by the multi-buffer backend
+const uint32_t lanes = 4;
 
-    // obtain vector of chars from input string
-    int num_chars = str.size();
-    std::vector<uint8_t> msg(str.c_str(), str.c_str() + str.size());
+//********************************************************************************************************************
 
-    // the string of bits reads from left to right and is indexed from left to right (i.e. big-endian)
-    // however, this code does bitwise operations from right to left (i.e. little-endian)
-    // therefore, the bits in each byte in the input string must be reversed
-    // std::transform(msg.cbegin(), msg.cend(), msg.begin(), [](uint8_t x){return gv::reverse_b<uint8_t>(x);});
-    // CORRECTION : this is not true, the bits are not reversed as otherwise the output is incorrect!
+// FUNCTION DECLARATIONS
 
-    // the message will be divided into blocks of 1088 bits (= rate)
-    // a suffix of 01 is applied meaning 1 byte will be appended to the input string
-    // a padding rule of 10*1 is applied
+// step mappings
+constexpr state_t theta(const state_t& state);
+constexpr state_t pi(const state_t& state);
+constexpr state_t rho(const state_t& state);
+constexpr state_t chi(const state_t& state);
+constexpr state_t iota(const int& i, const state_t& state);
+constexpr uint64_t RC(const int& i);
 
-    // calculate number of extra bytes
-    int extra_bytes = gv::modulo(-num_chars - 1, rate/8);
+// KECCAK-p[1600, 24] permutation
+constexpr void keccak_f(state_t& state);
 
-    // extend msg vector of bytes to contain extra bytes
-    msg.insert(msg.cend(), extra_bytes + 1, 0);
+// XORs a block of block_bytes bytes into the state (little-endian lanes)
+constexpr void absorb_block(state_t& state, const uint8_t* block);
 
-    //std::cout << "Extra bytes needed: " << (extra_bytes + 1) << " | Number of bytes in padded message: " << msg.size() << std::endl;
+// takes the digest from the first 4 lanes of the state
+constexpr digest_t squeeze(const state_t& state);
 
-    // add padding to message
-    if (extra_bytes == 0)
-    {
-        // only 1 byte needs to be added; this byte is: 
-        // 0110 0001 (big endian)
-        // 1000 0110 (little endian)
-        // 8    6    (little endian hexcode)
-        *(msg.end() - 1) = reverse_b<uint8_t>(0b01100001);
-    }
-    else
-    {
-        // two bytes need to be added; these bytes are
-        // 0110 0000 || ... || 0000 0001 (big endian)
-        // 0000 0110 || ... || 1000 0000
-        // 0    6    || ... || 8    0
-        msg[num_chars] = reverse_b<uint8_t>(0b01100000);
-        *(msg.end() - 1) = reverse_b<uint8_t>(0b00000001);
-    }
+// main digest fcns
+// hash can be evaluated at compile time, e.g. constexpr gv::sha3_256::digest_t d = gv::sha3_256::hash("hello");
+constexpr digest_t hash(std::string_view str);
+std::string digest(const std::string& str);
 
-    // copy message into vector 64-bit words
-    assert((num_chars + 1 + extra_bytes) % 8 == 0);
-    std::vector<uint64_t> padmsg((uint64_t*)msg.data(), (uint64_t*)(msg.data()) + (num_chars + 1 + extra_bytes)/8);
+// hashes each string, using the AVX2 multi-buffer backend (4 messages at once) where available
+std::vector<digest_t> hash_batch(const std::vector<std::string>& strs);
+std::vector<std::string> digest_batch(const std::vector<std::string>& strs);
 
-    //print_hex_grid(padmsg);
+#ifdef GV_X86_DISPATCH
+// absorbs one block into each of 4 lanes and applies KECCAK-f, the state is stored lane-major (state[lane index][message])
+// messages with their bit clear in active keep their previous state
+void absorb_avx2_x4(uint64_t state[25][4], const uint8_t* const blocks[4], uint32_t active);
+#endif
 
-    // divide padded message into blocks of 17 * 64-bit words
-    std::vector<std::vector<uint64_t>> blocks;
-    assert(padmsg.size() % 17 == 0);
-    for (int i = 0; i < padmsg.size() / 17; ++i)
-        blocks.push_back(std::vector<uint64_t>(padmsg.cbegin() + i*17, padmsg.cbegin() + (i+1)*17));
+// hexcode fcns
+template <typename T>
+std::string hex(const std::vector<T>& x);
+template <typename T>
+void print_hex_grid(std::vector<T>& x);
 
-    //std::cout << "Number of blocks: " << blocks.size() << std::endl;
+//********************************************************************************************************************
 
-    // *****************************************************
+// STREAMING
 
-    // SPONGE FUNCTION
+// streaming SHA3-256
+// the midstate can be saved with export_state and resumed with import_state, so that a growing
+// message (e.g. an append-only file) only needs its new bytes hashed
+class context
+{
 
-    // initialise state as zeros
-    std::vector<uint64_t> state(25, 0);
+public:
+    context() = default;
 
-    // iterate through blocks and absorb them
-    for (int n = 0; n < blocks.size(); ++n)
-    {
-        // copy 17*64-bit word block into state
-        std::vector<uint64_t> buf(25, 0);
-        std::copy(blocks[n].begin(), blocks[n].end(), buf.begin());
+    void update(const uint8_t* data, size_t len);
+    void update(std::string_view str) { update((const uint8_t*)str.data(), str.size()); }
 
-        // calculate state XOR (P0 || 0^c) (buf) and write into state
-        std::transform(buf.cbegin(), buf.cend(), state.cbegin(), state.begin(),
-            [](uint64_t x0, uint64_t x1){return x0 ^ x1;});
+    // digest of everything hashed so far, the context can still be updated afterwards
+    digest_t finalize() const;
+    std::string digest() const { return bytes_to_hexcode(finalize()); }
 
-        //std::cout << "\n\n Initial state:\n"; print_hex_grid(state);
+    // number of message bytes hashed so far, i.e. the offset to resume from
+    uint64_t length() const { return msg_len; }
 
-        // perform KECCAK function on state
-        // iterate rounds (number of rounds = 12+2*l, l = 6)
-        for (int i = 0; i < 12+2*6; ++i)
-        {
-            //std::cout << "\n\n ~~~~ ROUND " << i << std::endl;
-            
-            // theta
-            state = theta(state);           //std::cout << "\n\nState after theta:\n";    print_hex_grid(state);
+    // serialises the 25 lanes, the message length and the partial block (format in crypto_useful.hpp)
+    std::string export_state() const;
 
-            // rho
-            state = rho(state);             //std::cout << "\n\nState after rho:\n";      print_hex_grid(state);
+    // throws std::invalid_argument if data is not a valid SHA3-256 midstate
+    static context import_state(const std::string& data);
 
-            // pi
-            state = pi(state);              //std::cout << "\n\nState after pi:\n";       print_hex_grid(state);
+private:
+    state_t state = {};
+    std::array<uint8_t, block_bytes> buffer = {};
+    uint64_t msg_len = 0;
+};
 
-            // chi
-            state = chi(state);             //std::cout << "\n\nState after chi:\n";      print_hex_grid(state);
+//********************************************************************************************************************
 
-            // iota
-            state = iota(i, state);         //std::cout << "\n\nState after iota:\n";     print_hex_grid(state);
-        
+// round constant function
+constexpr uint64_t RC(const int& i)
+{
+    uint64_t rc = 0;
+    for (int j = 0; j <= 6; ++j)
+    {
+        int m = gv::modulo(j + 7*i, 255);
+        if (m != 0)
+        {
+            uint64_t R = 1;
+            for (int k = 0; k < m; ++k)
+            {
+                R = R << 1;
+                bool r8 = gv::check_bit<uint64_t,0>(R, 8);
+                gv::set_bit<uint64_t,0>(R, 0, gv::check_bit<uint64_t,0>(R, 0) ^ r8);
+                gv::set_bit<uint64_t,0>(R, 4, gv::check_bit<uint64_t,0>(R, 4) ^ r8);
+                gv::set_bit<uint64_t,0>(R, 5, gv::check_bit<uint64_t,0>(R, 5) ^ r8);
+                gv::set_bit<uint64_t,0>(R, 6, gv::check_bit<uint64_t,0>(R, 6) ^ r8);
+                R = R & (uint64_t)0xff;
+            }
+            gv::set_bit<uint64_t,0>(rc, (1<<j)-1, gv::check_bit<uint64_t,0>(R, 0));
         }
+        else
+            gv::set_bit<uint64_t,0>(rc, (1<<j)-1, 1);
     }
+    return rc;
+}
 
-    // convert state 64-bit vector into 8-bit vector
-    std::vector<uint8_t> state_8bit((uint8_t*)state.data(), (uint8_t*)(state.data()) + 200);
-
-    // require 256-bit digest = 32 bytes
-    std::vector<uint8_t> digest(state_8bit.begin(), state_8bit.begin() + 32);
-
-    std::string digest_hex = gv::sha3_256::hex(digest);
-
-    return digest_hex;
+// round constants for the 12+2*l = 24 rounds, computed once at compile time
+constexpr std::array<uint64_t, 24> round_constants()
+{
+    std::array<uint64_t, 24> rc = {};
+    for (int i = 0; i < 24; ++i)
+        rc[i] = RC(i);
+    return rc;
 }
 
+constexpr std::array<uint64_t, 24> RC_table = round_constants();
+
 // theta step mapping
-std::vector<uint64_t> theta(const std::vector<uint64_t>& state)
+constexpr state_t theta(const state_t& state)
 {
-    std::vector<uint64_t> buf(5);
-    std::vector<uint64_t> buf2(5);
-    std::vector<uint64_t> new_state(25);
+    std::array<uint64_t, 5> buf = {};
+    std::array<uint64_t, 5> buf2 = {};
+    state_t new_state = {};
     for (int x = 0; x < 5; ++x)
         buf[x] = state[5*0+x] ^ state[5*1+x] ^ state[5*2+x] ^ state[5*3+x] ^ state[5*4+x];
     for (int x = 0; x < 5; ++x)
@@ -197,12 +190,12 @@ std::vector<uint64_t> theta(const std::vector<uint64_t>& state)
 }
 
 // rho step mapping
-std::vector<uint64_t> rho(const std::vector<uint64_t>& state)
+constexpr state_t rho(const state_t& state)
 {
-    std::vector<uint64_t> new_state = state;
+    state_t new_state = state;
     int x = 1; 
     int y = 0;
-    int tmp;
+    int tmp = 0;
     for (int t = 0; t <= 23; ++t)
     {
         new_state[5*y + x] = gv::circ_left_shift(state[5*y + x], (t+1)*(t+2)/2);
@@ -214,9 +207,9 @@ std::vector<uint64_t> rho(const std::vector<uint64_t>& state)
 }
 
 // pi step mapping
-std::vector<uint64_t> pi(const std::vector<uint64_t>& state)
+constexpr state_t pi(const state_t& state)
 {
-    std::vector<uint64_t> new_state(25);
+    state_t new_state = {};
     for (int x = 0; x < 5; ++x)
         for (int y = 0; y < 5; ++y)
             new_state[5*y + x] = state[5*x + gv::modulo(x+3*y, 5)];
@@ -224,9 +217,9 @@ std::vector<uint64_t> pi(const std::vector<uint64_t>& state)
 }
 
 // chi step mapping
-std::vector<uint64_t> chi(const std::vector<uint64_t>& state)
+constexpr state_t chi(const state_t& state)
 {
-    std::vector<uint64_t> new_state(25);
+    state_t new_state = {};
     for (int x = 0; x < 5; ++x) {
         for (int y = 0; y < 5; ++y) {
             new_state[5*y + x] = state[5*y + x] ^ 
@@ -237,42 +230,291 @@ std::vector<uint64_t> chi(const std::vector<uint64_t>& state)
 }
 
 // iota step mapping
-std::vector<uint64_t> iota(const int& i, const std::vector<uint64_t>& state)
+constexpr state_t iota(const int& i, const state_t& state)
 {
-    uint64_t rc = RC(i);
-    std::vector<uint64_t> new_state = state;
-    new_state[5*0 + 0] = new_state[5*0 + 0] ^ rc;
+    state_t new_state = state;
+    new_state[5*0 + 0] = new_state[5*0 + 0] ^ RC_table[i];
     return new_state;
 }
 
-// round constant function
-uint64_t RC(const int& i)
+// perform KECCAK function on state
+// iterate rounds (number of rounds = 12+2*l, l = 6)
+constexpr void keccak_f(state_t& state)
 {
-    uint64_t rc = 0;
-    for (int j = 0; j <= 6; ++j)
+    for (int i = 0; i < 12+2*6; ++i)
     {
-        int m = gv::modulo(j + 7*i, 255);
-        if (m != 0)
+        state = theta(state);
+        state = rho(state);
+        state = pi(state);
+        state = chi(state);
+        state = iota(i, state);
+    }
+}
+
+// the bytes of each lane are read little-endian, independent of the host byte order
+constexpr void absorb_block(state_t& state, const uint8_t* block)
+{
+    for (uint32_t i = 0; i < block_bytes/8; ++i)
+    {
+        uint64_t lane = 0;
+        for (int j = 7; j >= 0; --j)
+            lane = (lane << 8) | block[8*i + j];
+        state[i] ^= lane;
+    }
+}
+
+// message digest
+constexpr digest_t hash(std::string_view str)
+{
+    // SPONGE FUNCTION
+
+    // initialise state as zeros
+    state_t state = {};
+
+    // the message is divided into blocks of 1088 bits (= rate), full blocks are absorbed straight from the input
+    uint64_t num_chars = str.size();
+    uint64_t num_full_blocks = num_chars / block_bytes;
+
+    std::array<uint8_t, block_bytes> block = {};
+    for (uint64_t n = 0; n < num_full_blocks; ++n)
+    {
+        for (uint32_t i = 0; i < block_bytes; ++i)
+            block[i] = (uint8_t)str[block_bytes*n + i];
+        absorb_block(state, block.data());
+        keccak_f(state);
+    }
+
+    // PADDING
+
+    // a suffix of 01 is applied and then a padding rule of 10*1, which together always fit in the final block
+    // the first padding byte is
+    // 0110 0000 (big endian)
+    // 0000 0110 (little endian)
+    // and the last byte of the block is
+    // 0000 0001 (big endian)
+    // 1000 0000 (little endian)
+    // if these are the same byte, it becomes 1000 0110 (little endian)
+    uint64_t num_tail_chars = num_chars % block_bytes;
+    block = {};
+    for (uint64_t i = 0; i < num_tail_chars; ++i)
+        block[i] = (uint8_t)str[block_bytes*num_full_blocks + i];
+    sha3_pad_block(block.data(), num_tail_chars, block_bytes);
+
+    absorb_block(state, block.data());
+    keccak_f(state);
+
+    return squeeze(state);
+}
+
+// SQUEEZE
+
+// require 256-bit digest = 32 bytes, taken from the first 4 lanes
+constexpr digest_t squeeze(const state_t& state)
+{
+    digest_t digest = {};
+    for (int i = 0; i < 32; ++i)
+        digest[i] = (uint8_t)(state[i/8] >> (8*(i%8)));
+
+    return digest;
+}
+
+std::string digest(const std::string& str)
+{
+    return bytes_to_hexcode(hash(str));
+}
+
+std::vector<digest_t> hash_batch(const std::vector<std::string>& strs)
+{
+    std::vector<digest_t> out(strs.size());
+
+#ifdef GV_X86_DISPATCH
+    if (cpu().avx2)
+    {
+        auto pad = [](const uint8_t* tail, size_t tail_len, uint64_t) { return sha3_pad(tail, tail_len, block_bytes); };
+
+        for (size_t first = 0; first < strs.size(); first += lanes)
         {
-            uint64_t R = 1;
-            for (int k = 0; k < m; ++k)
+            uint32_t num_lanes = (strs.size() - first < lanes) ? strs.size() - first : lanes;
+            lane_schedule<lanes, block_bytes> schedule(&strs[first], num_lanes, pad);
+
+            alignas(32) uint64_t state[25][4] = {};
+
+            for (size_t b = 0; b < schedule.num_blocks(); ++b)
             {
-                R = R << 1;
-                bool r8 = gv::check_bit<uint64_t,0>(R, 8);
-                gv::set_bit<uint64_t,0>(R, 0, gv::check_bit<uint64_t,0>(R, 0) ^ r8);
-                gv::set_bit<uint64_t,0>(R, 4, gv::check_bit<uint64_t,0>(R, 4) ^ r8);
-                gv::set_bit<uint64_t,0>(R, 5, gv::check_bit<uint64_t,0>(R, 5) ^ r8);
-                gv::set_bit<uint64_t,0>(R, 6, gv::check_bit<uint64_t,0>(R, 6) ^ r8);
-                R = R & (uint64_t)0xff;
+                const uint8_t* blocks[4];
+                uint32_t active = schedule.blocks(b, blocks);
+                absorb_avx2_x4(state, blocks, active);
+            }
+
+            for (uint32_t l = 0; l < num_lanes; ++l)
+            {
+                state_t lane_state = {};
+                for (int i = 0; i < 4; ++i)
+                    lane_state[i] = state[i][l];
+                out[first + l] = squeeze(lane_state);
             }
-            gv::set_bit<uint64_t,0>(rc, (1<<j)-1, gv::check_bit<uint64_t,0>(R, 0));
         }
-        else
-            gv::set_bit<uint64_t,0>(rc, (1<<j)-1, 1);
+        return out;
     }
-    return rc;
+#endif
+
+    for (size_t i = 0; i < strs.size(); ++i)
+        out[i] = hash(strs[i]);
+    return out;
+}
+
+std::vector<std::string> digest_batch(const std::vector<std::string>& strs)
+{
+    std::vector<digest_t> digests = hash_batch(strs);
+    std::vector<std::string> hexcodes(digests.size());
+    for (size_t i = 0; i < digests.size(); ++i)
+        hexcodes[i] = bytes_to_hexcode(digests[i]);
+    return hexcodes;
 }
 
+void context::update(const uint8_t* data, size_t len)
+{
+    size_t buffered = msg_len % block_bytes;
+    msg_len += len;
+
+    // top up a partial block first
+    if (buffered > 0)
+    {
+        size_t take = (len < block_bytes - buffered) ? len : block_bytes - buffered;
+        std::memcpy(buffer.data() + buffered, data, take);
+        data += take;
+        len -= take;
+        if (buffered + take < block_bytes)
+            return;
+        absorb_block(state, buffer.data());
+        keccak_f(state);
+    }
+
+    for (; len >= block_bytes; data += block_bytes, len -= block_bytes)
+    {
+        absorb_block(state, data);
+        keccak_f(state);
+    }
+
+    std::memcpy(buffer.data(), data, len);
+}
+
+digest_t context::finalize() const
+{
+    size_t buffered = msg_len % block_bytes;
+    std::array<uint8_t, block_bytes> block = {};
+    std::memcpy(block.data(), buffer.data(), buffered);
+    sha3_pad_block(block.data(), buffered, block_bytes);
+
+    state_t final_state = state;
+    absorb_block(final_state, block.data());
+    keccak_f(final_state);
+    return squeeze(final_state);
+}
+
+std::string context::export_state() const
+{
+    return export_midstate(midstate_algorithm::sha3_256, msg_len, state, buffer.data(), block_bytes);
+}
+
+context context::import_state(const std::string& data)
+{
+    context ctx;
+    import_midstate(data, midstate_algorithm::sha3_256, ctx.msg_len, ctx.state, ctx.buffer.data(), block_bytes);
+    return ctx;
+}
+
+#ifdef GV_X86_DISPATCH
+
+// rotation of each lane in the rho step, following the same walk over (x, y) as rho
+constexpr std::array<uint32_t, 25> rho_offsets()
+{
+    std::array<uint32_t, 25> offsets = {};
+    int x = 1;
+    int y = 0;
+    int tmp = 0;
+    for (int t = 0; t <= 23; ++t)
+    {
+        offsets[5*y + x] = ((t+1)*(t+2)/2) % 64;
+        tmp = x;
+        x = y;
+        y = gv::modulo((2*tmp + 3*y), 5);
+    }
+    return offsets;
+}
+
+constexpr std::array<uint32_t, 25> rho_table = rho_offsets();
+
+#define GV_ROTL64_X4(x, n) _mm256_or_si256(_mm256_slli_epi64(x, n), _mm256_srli_epi64(x, 64 - (n)))
+
+__attribute__((target("avx2")))
+void absorb_avx2_x4(uint64_t state[25][4], const uint8_t* const blocks[4], uint32_t active)
+{
+    __m256i A[25];
+    __m256i prev[25];
+    for (int i = 0; i < 25; ++i)
+        prev[i] = _mm256_load_si256((const __m256i*)state[i]);
+
+    // XOR the 17 block lanes of each message into the state
+    for (int quarter = 0; quarter < 4; ++quarter)
+    {
+        __m256i r[4];
+        for (int l = 0; l < 4; ++l)
+            r[l] = _mm256_loadu_si256((const __m256i*)(blocks[l] + 32*quarter));
+        transpose_4x4_epi64(r);
+        for (int i = 0; i < 4; ++i)
+            A[4*quarter + i] = _mm256_xor_si256(prev[4*quarter + i], r[i]);
+    }
+    uint64_t last[4];
+    for (int l = 0; l < 4; ++l)
+        std::memcpy(&last[l], blocks[l] + 128, 8);
+    A[16] = _mm256_xor_si256(prev[16], _mm256_loadu_si256((const __m256i*)last));
+    for (int i = 17; i < 25; ++i)
+        A[i] = prev[i];
+
+    // the step loops are fully unrolled so that the lanes stay in registers and the rotations use immediate counts
+    for (int round = 0; round < 12+2*6; ++round)
+    {
+        // theta
+        __m256i C[5], D[5];
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x)
+            C[x] = _mm256_xor_si256(_mm256_xor_si256(_mm256_xor_si256(A[x], A[5 + x]), _mm256_xor_si256(A[10 + x], A[15 + x])), A[20 + x]);
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x)
+            D[x] = _mm256_xor_si256(C[(x + 4) % 5], GV_ROTL64_X4(C[(x + 1) % 5], 1));
+
+        // rho and pi
+        __m256i B[25];
+        #pragma GCC unroll 5
+        for (int x = 0; x < 5; ++x)
+            #pragma GCC unroll 5
+            for (int y = 0; y < 5; ++y)
+            {
+                int src = 5*x + (x + 3*y) % 5;
+                B[5*y + x] = GV_ROTL64_X4(_mm256_xor_si256(A[src], D[src % 5]), rho_table[src]);
+            }
+
+        // chi
+        #pragma GCC unroll 5
+        for (int y = 0; y < 5; ++y)
+            #pragma GCC unroll 5
+            for (int x = 0; x < 5; ++x)
+                A[5*y + x] = _mm256_xor_si256(B[5*y + x], _mm256_andnot_si256(B[5*y + (x + 1) % 5], B[5*y + (x + 2) % 5]));
+
+        // iota
+        A[0] = _mm256_xor_si256(A[0], _mm256_set1_epi64x(RC_table[round]));
+    }
+
+    __m256i mask = lane_mask_epi64(active);
+    for (int i = 0; i < 25; ++i)
+        _mm256_store_si256((__m256i*)state[i], _mm256_blendv_epi8(prev[i], A[i], mask));
+}
+
+#undef GV_ROTL64_X4
+
+#endif
+
 // print message in sha3-style hexcode
 // the data is little endian style but the byte order
 // is flipped to read from left to right
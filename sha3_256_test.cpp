@@ -1,10 +1,54 @@
 #include <iostream>
 #include "sha3_256.hpp"
 
+// the digest of a literal is a compile-time constant
+static_assert(gv::digest_word<uint32_t>(gv::sha3_256::hash("hello")) == 0x3338be69, "SHA3-256 of hello should start with 3338be69");
+
 int main(int argc, char* argv[]) {
+    // hash a message in two sessions, saving the midstate in between, for split points around the block edges
+    std::string message;
+    for (int i = 0; i < 400; ++i)
+        message.push_back((char)(i * 37));
+
+    bool resumed_ok = true;
+    for (size_t split : {0, 1, 135, 136, 137, 272, 399, 400}) {
+        gv::sha3_256::context first;
+        first.update(std::string_view(message).substr(0, split / 2));
+        first.update(std::string_view(message).substr(split / 2, split - split / 2));
+
+        gv::sha3_256::context second = gv::sha3_256::context::import_state(first.export_state());
+        second.update(std::string_view(message).substr(split));
+        resumed_ok = resumed_ok && second.length() == message.size() && second.finalize() == gv::sha3_256::hash(message);
+    }
+    std::cout << "Resumed from midstate: " << (resumed_ok ? "same digest" : "DIFFERENT digest") << " (should be same digest)" << std::endl;
+
+    // malformed midstates must be rejected: bad magic, version, algorithm and length
+    gv::sha3_256::context partial;
+    partial.update(message.substr(0, 200));
+    std::string state = partial.export_state();
+
+    int num_rejected = 0;
+    for (int field : {0, 4, 5, -1}) {
+        std::string bad = state;
+        if (field < 0)
+            bad.pop_back();
+        else
+            bad[field] ^= 0x7f;
+
+        try {
+            gv::sha3_256::context::import_state(bad);
+        }
+        catch (const std::invalid_argument&) {
+            ++num_rejected;
+        }
+    }
+    std::cout << "Malformed midstates rejected: " << num_rejected << " of 4" << std::endl;
+
     // if a string input is provided, argc >= 2. The first element of argv is the executable name
     // the second element of the array is the desired input. We take the first complete string without spaces.
     if (argc > 1) {
         std::cout << argv[1] << " >>>> SHA3-256 >>>> " << gv::sha3_256::digest(std::string(argv[1])) << std::endl;
     }
-}
\ No newline at end of file
+
+    return (resumed_ok && num_rejected == 4) ? 0 : 1;
+}